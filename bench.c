@@ -0,0 +1,399 @@
+// 
+// bench.c
+// Copyright (C) 2014  Florian Tanner <florian.tanner@gmail.com>
+// 
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+// 
+
+
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdatomic.h>
+#include <unistd.h>
+
+#include "binoxxo.h"
+#include "binoxxo_io.h"
+#include "binoxxo_solver.h"
+
+///
+/// Default number of runs per binoxxo
+///
+#define BENCH_RUNS 5
+
+///
+/// Binoxxos generated from every solved binoxxo and share of fields they
+/// leave empty, in percent
+///
+#define BENCH_VARIANTS 8
+static const int bench_empty[] = {50, 70};
+
+///
+/// Guess modes to measure
+///
+static const struct {
+	const char *name;
+	int mode;
+} bench_mode[] = {
+	{"none",        BNX_GUESS_NONE},
+	{"topleft",     BNX_GUESS_TOPLEFT},
+	{"mostfilled",  BNX_GUESS_MOSTFILLED},
+	{"random",      BNX_GUESS_RANDOM},
+	{"constrained", BNX_GUESS_CONSTRAINED},
+	{"sat",         BNX_GUESS_SAT},
+};
+
+///
+/// Set of binoxxos measured together
+///
+struct BenchCorpus {
+	char name[32];
+	struct Bnx **puzzle;
+	size_t count;
+	size_t capacity;
+	int sol_mode;
+};
+
+///
+/// Result of one corpus and guess mode
+///
+struct BenchResult {
+	size_t solutions;
+	unsigned long nodes;			// Per run over all binoxxos
+	unsigned long allocations;		// Per run over all binoxxos
+	double median;					// Seconds per binoxxo
+	double p99;
+};
+
+// Allocations are counted by wrapping the allocator at link time
+static atomic_ulong bench_allocations;
+
+void *__real_malloc(size_t);
+void *__real_calloc(size_t, size_t);
+void *__real_realloc(void *, size_t);
+
+void *
+__wrap_malloc(size_t size)
+{
+	atomic_fetch_add_explicit(&bench_allocations, 1, memory_order_relaxed);
+	return __real_malloc(size);
+}
+
+void *
+__wrap_calloc(size_t count, size_t size)
+{
+	atomic_fetch_add_explicit(&bench_allocations, 1, memory_order_relaxed);
+	return __real_calloc(count, size);
+}
+
+void *
+__wrap_realloc(void *p, size_t size)
+{
+	atomic_fetch_add_explicit(&bench_allocations, 1, memory_order_relaxed);
+	return __real_realloc(p, size);
+}
+
+static double
+bench_now(void)
+{
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (double)now.tv_sec + (double)now.tv_nsec / 1e9;
+}
+
+static int
+bench_compare(const void *a, const void *b)
+{
+	const double x = *(const double *)a;
+	const double y = *(const double *)b;
+	return (x > y) - (x < y);
+}
+
+static int
+bench_corpus_add(struct BenchCorpus *corpus, struct Bnx *b)
+{
+	if (corpus->count == corpus->capacity) {
+		const size_t capacity = corpus->capacity ? 2 * corpus->capacity : 64;
+		struct Bnx **puzzle = realloc(corpus->puzzle,
+			capacity * sizeof(struct Bnx *));
+		if (puzzle == NULL) {
+			return -ENOMEM;
+		}
+		corpus->puzzle   = puzzle;
+		corpus->capacity = capacity;
+	}
+
+	corpus->puzzle[corpus->count++] = b;
+
+	return 0;
+}
+
+static void
+bench_corpus_free(struct BenchCorpus *corpus)
+{
+	size_t i;
+
+	for (i = 0; i < corpus->count; i++) {
+		bnx_free(corpus->puzzle[i]);
+	}
+	free(corpus->puzzle);
+}
+
+static void
+bench_load(struct BenchCorpus *corpus, const char *filename)
+{
+	struct BnxMap map;
+	size_t i;
+
+	if (bnx_map_open(&map, filename) != 0) {
+		return;
+	}
+
+	for (i = 0; i < map.count; i++) {
+		struct Bnx *b = bnx_map_get(&map, i, NULL);
+		if (b != NULL && bench_corpus_add(corpus, b) != 0) {
+			bnx_free(b);
+		}
+	}
+
+	bnx_map_close(&map);
+}
+
+static struct Bnx *
+bench_copy(struct Bnx const * const b)
+{
+	struct Bnx *copy = bnx_alloc(b->size);
+	if (copy != NULL) {
+		memcpy(copy->data[0], b->data[0], b->size * b->size * sizeof(int));
+	}
+	return copy;
+}
+
+static struct BnxSolution *
+bench_solve(struct Bnx const * const b, const int mode, const int sol_mode,
+            unsigned long *nodes)
+{
+	struct BnxCollector collector;
+
+	bnx_collector_init(&collector, sol_mode);
+
+	struct BnxSolverCtx *ctx = bnx_ctx_alloc(b, mode, &collector);
+	*nodes = 0;
+	if (ctx != NULL) {
+		bnx_solve_ctx(ctx);
+		*nodes = ctx->stats.nodes;
+		bnx_ctx_free(ctx);
+	}
+
+	return bnx_collector_destroy(&collector);
+}
+
+static void
+bench_generate(struct BenchCorpus *corpus, struct BenchCorpus const *source,
+               const int empty)
+{
+	// Fixed seed, every build measures the same binoxxos
+	unsigned long seed = 1;
+	size_t i;
+
+	for (i = 0; i < source->count; i++) {
+		unsigned long nodes;
+		struct BnxSolution *s = bench_solve(source->puzzle[i],
+			BNX_GUESS_MOSTFILLED, BNX_SOLUTION_MODE_ONE, &nodes);
+		if (s == NULL) {
+			continue;
+		}
+
+		const size_t cells = s->data->size * s->data->size;
+		int v;
+		for (v = 0; v < BENCH_VARIANTS; v++) {
+			struct Bnx *b = bench_copy(s->data);
+			if (b == NULL) {
+				break;
+			}
+
+			size_t c;
+			for (c = 0; c < cells; c++) {
+				seed = seed * 6364136223846793005UL + 1442695040888963407UL;
+				if ((seed >> 33) % 100 < empty) {
+					b->data[0][c] = BNX_FIELD_EMPTY;
+				}
+			}
+
+			if (bench_corpus_add(corpus, b) != 0) {
+				bnx_free(b);
+			}
+		}
+
+		bnx_solution_free(s);
+	}
+}
+
+static size_t
+bench_count(struct BnxSolution *s)
+{
+	size_t count = 0;
+
+	for (; s != NULL; s = s->next) {
+		count++;
+	}
+
+	return count;
+}
+
+static void
+bench_run(struct BenchCorpus const *corpus, const int mode, const int runs,
+          struct BenchResult *result)
+{
+	double *time = malloc(sizeof(double) * runs);
+	double *median = malloc(sizeof(double) * (corpus->count + 1));
+	size_t i;
+
+	memset(result, 0, sizeof(struct BenchResult));
+	if (time == NULL || median == NULL) {
+		goto bench_run_cleanup;
+	}
+
+	for (i = 0; i < corpus->count; i++) {
+		int r;
+		for (r = 0; r < runs; r++) {
+			const unsigned long allocations = atomic_load(&bench_allocations);
+			const double start = bench_now();
+
+			unsigned long nodes;
+			struct BnxSolution *s = bench_solve(corpus->puzzle[i], mode,
+			                                    corpus->sol_mode, &nodes);
+
+			time[r] = bench_now() - start;
+
+			// Counts are equal for every run, keep the first
+			if (r == 0) {
+				result->allocations += atomic_load(&bench_allocations)
+					- allocations;
+				result->nodes       += nodes;
+				result->solutions   += bench_count(s);
+			}
+			bnx_solution_free(s);
+		}
+
+		qsort(time, runs, sizeof(double), &bench_compare);
+		median[i] = time[runs / 2];
+	}
+
+	if (corpus->count > 0) {
+		qsort(median, corpus->count, sizeof(double), &bench_compare);
+		result->median = median[corpus->count / 2];
+		result->p99    = median[(corpus->count * 99 + 99) / 100 - 1];
+	}
+
+bench_run_cleanup:
+	free(time);
+	free(median);
+}
+
+int
+main(int argc, char **argv)
+{
+	const char *output = "bench.json";
+	int runs = BENCH_RUNS;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "o:r:")) != -1) {
+		switch (opt) {
+			case 'o':
+				output = optarg;
+				break;
+
+			case 'r':
+				runs = atoi(optarg);
+				break;
+
+			default:
+				fprintf(stderr, "Usage: %s [-r runs] [-o result] file...\n",
+					argv[0]);
+				return EXIT_FAILURE;
+		}
+	}
+
+	if (runs < 1) {
+		runs = 1;
+	}
+
+	const size_t generated = sizeof(bench_empty) / sizeof(bench_empty[0]);
+	const size_t modes = sizeof(bench_mode) / sizeof(bench_mode[0]);
+	struct BenchCorpus corpus[1 + generated];
+	size_t i;
+
+	memset(corpus, 0, sizeof(corpus));
+	strcpy(corpus[0].name, "data");
+	corpus[0].sol_mode = BNX_SOLUTION_MODE_ALL;
+
+	for (i = optind; i < argc; i++) {
+		bench_load(&corpus[0], argv[i]);
+	}
+
+	bnx_lines_init();
+
+	// Generated binoxxos may have many solutions, only search the first
+	for (i = 0; i < generated; i++) {
+		snprintf(corpus[i + 1].name, sizeof(corpus[i + 1].name),
+		         "generated-%d", bench_empty[i]);
+		corpus[i + 1].sol_mode = BNX_SOLUTION_MODE_ONE;
+		bench_generate(&corpus[i + 1], &corpus[0], bench_empty[i]);
+	}
+
+	FILE *file = fopen(output, "w");
+	if (!file) {
+		fprintf(stderr, "Could not open file %s\n", output);
+		return EXIT_FAILURE;
+	}
+
+	fprintf(file, "{\n  \"runs\": %d,\n  \"results\": [", runs);
+	printf("%-14s %-11s %7s %9s %12s %12s %12s %12s\n", "corpus", "mode",
+	       "puzzles", "solutions", "median [us]", "p99 [us]", "nodes",
+	       "allocations");
+
+	int first = true;
+	size_t c;
+	size_t m;
+	for (c = 0; c < 1 + generated; c++) {
+		for (m = 0; m < modes; m++) {
+			struct BenchResult result;
+			bench_run(&corpus[c], bench_mode[m].mode, runs, &result);
+
+			printf("%-14s %-11s %7zu %9zu %12.1f %12.1f %12lu %12lu\n",
+			       corpus[c].name, bench_mode[m].name, corpus[c].count,
+			       result.solutions, result.median * 1e6, result.p99 * 1e6,
+			       result.nodes, result.allocations);
+
+			fprintf(file, "%s\n    {\"corpus\": \"%s\", \"mode\": \"%s\", "
+			        "\"puzzles\": %zu, \"solutions\": %zu, "
+			        "\"median_us\": %.3f, \"p99_us\": %.3f, "
+			        "\"nodes\": %lu, \"allocations\": %lu}",
+			        first ? "" : ",", corpus[c].name, bench_mode[m].name,
+			        corpus[c].count, result.solutions, result.median * 1e6,
+			        result.p99 * 1e6, result.nodes, result.allocations);
+			first = false;
+		}
+	}
+
+	fprintf(file, "\n  ]\n}\n");
+	fclose(file);
+
+	for (c = 0; c < 1 + generated; c++) {
+		bench_corpus_free(&corpus[c]);
+	}
+
+	return EXIT_SUCCESS;
+}
@@ -18,59 +18,59 @@
 
 
 #include "binoxxo.h"
+#include "binoxxo_board.h"
+#include "binoxxo_random.h"
 
 const size_t bnx_min_size = 4;
 
+size_t
+bnx_alloc_size(const size_t size)
+{
+	return sizeof(struct Bnx) + size * sizeof(int *)
+		+ size * size * sizeof(enum BnxField);
+}
+
+struct Bnx *
+bnx_init(void *block, const size_t size)
+{
+	struct Bnx *b = block;
+
+	// Row pointers and fields follow the structure in the same block
+	b->size = size;
+	b->data = (int **)(b + 1);
+	b->data[0] = (int *)(b->data + size);
+	memset(b->data[0], 0, size * size * sizeof(enum BnxField));
+
+	int i;
+	for (i = 1; i < size; i++) {
+		b->data[i] = b->data[0] + i * size;
+	}
+
+	return b;
+}
+
 struct Bnx *
 bnx_alloc(const size_t size)
 {
-	if (size < bnx_min_size || size % 2 != 0) {
-		fprintf(stderr, "Size must be at least %zu and a multiple of 2\n",
-			bnx_min_size);
+	if (size < bnx_min_size || size > BNX_MAX_SIZE || size % 2 != 0) {
+		fprintf(stderr, "Size must be between %zu and %d and a multiple "
+			"of 2\n", bnx_min_size, BNX_MAX_SIZE);
 		return NULL;
 	}
 	
-	struct Bnx* b = malloc(sizeof(struct Bnx));
-	if (b == NULL) {
-		goto bnx_alloc_cleanup;
-	}
-	
-	b->data = malloc(sizeof(enum BnxField*) * size);
-	if (b->data == NULL) {
-		goto bnx_alloc_cleanup_data;
-	}
-	
-	int i = 0;
-	for (i = 0; i < size; i++) {
-		b->data[i] = (enum BnxField*)calloc(size, sizeof(enum BnxField));
-		if (b->data[i] == NULL) {
-			goto bnx_alloc_cleanup_rows;
-		}
-	}
-	
-	b->size = size;
-	
-	return b;
-	
-bnx_alloc_cleanup_rows:
-	while(i) {
-		i--;
-		free(b->data[i]);
+	void *block = malloc(bnx_alloc_size(size));
+	if (block == NULL) {
+		fprintf(stderr, "Could not allocate memory\n");
+		return NULL;
 	}
-	free(b->data);
 	
-bnx_alloc_cleanup_data:
-	free(b);
-	
-bnx_alloc_cleanup:
-	fprintf(stderr, "Could not allocate memory\n");
-	return NULL;
+	return bnx_init(block, size);
 }
 
-int
-bnx_get_random_field_value(void)
+static int
+bnx_get_random_field_value(struct BnxRandom *r)
 {
-	if (rand() % 2) {
+	if (bnx_random_next(r) >> 63) {
 		return BNX_FIELD_O;
 	} else {
 		return BNX_FIELD_X;
@@ -78,17 +78,14 @@ bnx_get_random_field_value(void)
 }
 
 void
-bnx_randomize(struct Bnx const *b)
+bnx_randomize(struct Bnx const *b, struct BnxRandom *r)
 {
-	
-	srand(time(NULL));
-	
 	const size_t size = b->size;
 	int row;
 	int col;
 	for (row = 0; row < size; row++) {
 		for (col = 0; col < size; col++) {
-			b->data[row][col] = bnx_get_random_field_value();
+			b->data[row][col] = bnx_get_random_field_value(r);
 		}
 	}
 }
@@ -100,10 +97,8 @@ bnx_copy(struct Bnx const *dest, struct Bnx const * const src)
 		return -ENOMEM;
 	}
 
-	int i;
-	for (i = 0; i < src->size; i++) {
-		memcpy(dest->data[i], src->data[i], src->size * sizeof(enum BnxField));
-	}
+	memcpy(dest->data[0], src->data[0],
+	       src->size * src->size * sizeof(enum BnxField));
 	
 	return 0;
 }
@@ -111,72 +106,35 @@ bnx_copy(struct Bnx const *dest, struct Bnx const * const src)
 void
 bnx_free(struct Bnx *b)
 {
-	if (b != NULL) {
-		if (b->data != NULL) {
-			int i;
-			for (i = 0; i < b->size; i++) {
-				if (b->data[i] != NULL) {
-					free(b->data[i]);
-				}
-			}
-			free(b->data);
-		}
-		free(b);
-	}
-}
-
-struct BnxLine *
-bnx_get_line(struct Bnx const * const b, const int mode, const int index)
-{
-	const size_t size = b->size;
-	
-	struct BnxLine* line = malloc(sizeof(struct BnxLine));
-	if (line == NULL) {
-		fprintf(stderr, "Could not allocate memory for line\n");
-		return NULL;
-	} 
-	
-	line->data = malloc(sizeof(int*) * size);
-	if (line->data == NULL) {
-		fprintf(stderr, "Could not allocate memory for line data\n");
-		free(line);
-		return NULL;
-	}
-	
-	line->size = size;
-	
-	int i;
-	for (i = 0; i < size; i++) {
-		
-		if (mode & BNX_SCAN_H) {
-			line->data[i] = &b->data[index][i];
-		} else if (mode & BNX_SCAN_V) {
-			line->data[i] = &b->data[i][index];
-		}
-	}
-	
-	return line;
+	free(b);
 }
 
 void
-bnx_free_line(struct BnxLine *line)
+bnx_get_line(struct Bnx const * const b, const int mode, const int index,
+             struct BnxLine *line)
 {
-	free(line->data);
-	free(line);
+	line->size = b->size;
+
+	if (mode & BNX_SCAN_H) {
+		line->data   = b->data[index];
+		line->stride = 1;
+	} else {
+		line->data   = &b->data[0][index];
+		line->stride = b->size;
+	}
 }
 
 int
 bnx_scan(struct Bnx const * const b, BnxScannerFnc scanner, const int mode)
 {
 	int i;
-	int modified = true;
-	struct BnxLine* line;
+	int modified = false;
+	struct BnxLine line;
 	
 	for (i = 0; i < b->size; i++) {
 
-		line = bnx_get_line(b, mode, i);
-		modified = scanner(line);
-		bnx_free_line(line);
+		bnx_get_line(b, mode, i, &line);
+		modified |= scanner(&line);
 		
 		if ((mode & BNX_SCAN_ABORT) && modified) {
 			break;
@@ -194,22 +152,18 @@ bnx_compare_lines(struct Bnx const * const b,
 	int i;
 	int j;
 	int error = BNX_CORRECT;
-	struct BnxLine *line;
-	struct BnxLine *next;
+	struct BnxLine line;
+	struct BnxLine next;
 	
 	for (i = 0; i < size; i++) {
 
-		line = bnx_get_line(b, mode, i);
-		error = BNX_CORRECT;
+		bnx_get_line(b, mode, i, &line);
 
 		for (j = i + 1; j < size; j++) {
 	
-			next = bnx_get_line(b, mode, j);
-			error |= compare(line, next);
-			bnx_free_line(next);
+			bnx_get_line(b, mode, j, &next);
+			error |= compare(&line, &next);
 		}
-
-		bnx_free_line(line);
 		
 		if ((mode & BNX_SCAN_ABORT) && error) {
 			break;
@@ -219,80 +173,6 @@ bnx_compare_lines(struct Bnx const * const b,
 	return error;
 }
 
-static int
-bnx_validate_rule_triple(const int triple)
-{
-	if (abs(triple) < BNX_FIELD_OVER) {
-		return BNX_CORRECT;
-	}
-	return BNX_ERR_FOLLOW;
-}
-
-static int
-bnx_validate_rule_count(const int sum)
-{
-	if (sum == BNX_FIELD_EMPTY) {
-		return BNX_CORRECT;
-	}
-	return BNX_ERR_BALANCE;
-}
-
-static int
-bnx_validate_rule_empty(const int field)
-{
-	if (field != BNX_FIELD_EMPTY) {
-		return BNX_CORRECT;
-	}
-	return BNX_ERR_FILL;
-}
-
-static int
-bnx_validate_line(struct BnxLine const * const line)
-{
-	const size_t size = line->size - 1;
-	int i = 1;
-	int triple;
-	int sum = *line->data[0] + *line->data[size];
-	int error = bnx_validate_rule_empty(*line->data[0])
-		| bnx_validate_rule_empty(*line->data[size]);
-	
-	while (error == BNX_CORRECT && i < size) {
-	
-		sum    += *line->data[i];
-		triple = *line->data[i - 1] + *line->data[i] + *line->data[i + 1];
-		error  = bnx_validate_rule_empty(*line->data[i]);
-		
-		if (error == BNX_CORRECT) {
-			error |= bnx_validate_rule_triple(triple);
-		}
-		i++;
-	}
-	
-	if (i == size) {
-		error |= bnx_validate_rule_count(sum);
-	}
-
-	return error;
-}
-
-static int
-bnx_is_eq_and_not_empty(const int a, const int b)
-{
-	return a == b && a != BNX_FIELD_EMPTY;
-}
-
-static int
-bnx_has_empty(struct BnxLine const * const l)
-{
-	const size_t size = l->size;
-	int i = 0;
-	while (i < size && *l->data[i] != BNX_FIELD_EMPTY) {
-		i++;
-	}
-
-	return i < size;
-}
-
 int
 bnx_line_count_empty(struct BnxLine const * const l)
 {
@@ -300,7 +180,7 @@ bnx_line_count_empty(struct BnxLine const * const l)
 	int i = 0;
 	int count = 0;
 	while (i < size) {
-		if (*l->data[i] == BNX_FIELD_EMPTY) {
+		if (*bnx_line_field(l, i) == BNX_FIELD_EMPTY) {
 			count++;
 		}
 		i++;
@@ -309,36 +189,32 @@ bnx_line_count_empty(struct BnxLine const * const l)
 	return count;
 }
 
-static int
-bnx_validate_unique(struct BnxLine const * const a,
-                    struct BnxLine const * const b)
+int
+bnx_validate(struct Bnx const * const b)
 {
-	if (bnx_has_empty(a) || bnx_has_empty(b)) {
-		return BNX_CORRECT;
-	}
+	struct BnxBoard board;
 
-	const size_t size = a->size;
-	int i = 0;
-	while (i < size && bnx_is_eq_and_not_empty(*a->data[i], *b->data[i])) {
-		i++;
+	if (bnx_board_pack(&board, b) != 0) {
+		return BNX_ERR_UNKNOWN;
 	}
 
-	if (i < size) {
-		return BNX_CORRECT;
-	}
-	return BNX_ERR_UNIQUE;
+	return bnx_board_validate(&board);
 }
 
 int
-bnx_validate(struct Bnx const * const b)
+bnx_find_duplicate(struct Bnx const * const b, const int mode,
+                   int *first, int *second)
 {
-	int flags_h = BNX_SCAN_H | BNX_SCAN_ABORT;
-	int flags_v = BNX_SCAN_V | BNX_SCAN_ABORT;
+	struct BnxBoard board;
+
+	if (bnx_board_pack(&board, b) != 0) {
+		return BNX_ERR_UNKNOWN;
+	}
 
-	return bnx_scan(b, &bnx_validate_line, flags_h)
-		| bnx_scan(b, &bnx_validate_line, flags_v)
-		| bnx_compare_lines(b, &bnx_validate_unique, flags_h)
-		| bnx_compare_lines(b, &bnx_validate_unique, flags_v);
+	if (mode & BNX_SCAN_H) {
+		return bnx_board_find_duplicate(&board, BNX_DIR_H, first, second);
+	}
+	return bnx_board_find_duplicate(&board, BNX_DIR_V, first, second);
 }
 
 char *
@@ -360,6 +236,10 @@ bnx_strerror(const int error)
 		return "Triple of 'o' and 'x' found\n";
 	}
 
+	if (error & BNX_ERR_CONFLICT) {
+		return "Field must be 'o' and 'x' at once\n";
+	}
+
 	if (error == BNX_CORRECT) {
 		return "Binoxxo valid\n";
 	}
@@ -33,6 +33,11 @@
 ///
 #define BNX_SAFETY_CHECKS
 
+///
+/// Maximal size of a binoxxo, a line must fit into one machine word
+///
+#define BNX_MAX_SIZE 64
+
 ///
 /// Define default signs
 ///
@@ -43,6 +48,9 @@ enum BnxLetter {
 	BNX_LETTER_OVER  = '$',		// Used in guess maps to indicate blocked field
 };
 
+// Forward definition
+struct BnxRandom;
+
 ///
 /// Error data type
 ///
@@ -53,6 +61,7 @@ enum BnxError {
 	BNX_ERR_BALANCE = 1 << 2,
 	BNX_ERR_FOLLOW  = 1 << 3,
 	BNX_ERR_UNKNOWN = 1 << 4,
+	BNX_ERR_CONFLICT = 1 << 5,	// Field has to be 'o' and 'x' at once
 };
 
 ///
@@ -75,12 +84,12 @@ enum BnxScan {
 };
 
 ///
-/// Structure for holding pointers to line data
+/// View on a line of a binoxxo matrix, does not own any memory
 ///
 struct BnxLine {
 	size_t size;
-	int **data;		// Array of pointers referencing the value in
-					// a binoxxo matrix
+	size_t stride;	// Distance between two fields of the line
+	int *data;		// First field of the line inside a binoxxo matrix
 };
 
 ///
@@ -88,12 +97,13 @@ struct BnxLine {
 ///
 struct Bnx {
 	size_t size;
-	int **data;		// Dynamic array for storing the binoxxo as matrix
+	int **data;		// Row pointers into the fields, both follow the
+					// structure in one block
 };
 
 ///
 /// Function pointer for a solver function
-/// Takes as argument a line
+/// Takes as argument a line view
 /// Returns modification status
 ///
 typedef int
@@ -101,7 +111,7 @@ typedef int
 
 ///
 /// Function pointer for a comparator function
-/// Takes as argument two lines
+/// Takes as argument two line views
 /// Returns modification status
 ///
 typedef int
@@ -115,20 +125,41 @@ extern const size_t bnx_min_size;
 ///
 /// \brief Initialize binoxxo data structure
 ///
-/// \param Size of binoxxo. Must be multiple of 2
+/// \param Size of binoxxo. Must be multiple of 2 and at most BNX_MAX_SIZE
 /// \return Binoxxo data structure
 ///
 struct Bnx *
 bnx_alloc(const size_t);
 
+///
+/// \brief Bytes of the block holding a binoxxo, see bnx_init
+///
+/// \param Size of binoxxo
+/// \return Bytes
+///
+size_t
+bnx_alloc_size(const size_t);
+
+///
+/// \brief Initialize an empty binoxxo in a block of memory owned by the
+/// 	caller, the size is not checked
+///
+/// \param Block of at least bnx_alloc_size bytes, aligned for pointers
+/// \param Size of binoxxo
+/// \return Binoxxo data structure at the start of the block
+///
+struct Bnx *
+bnx_init(void *, const size_t);
+
 ///
 /// \brief Set random values to all fields
 /// \todo May returns invalid binoxxos!
 ///
 /// \param Binoxxo data structure
+/// \param Random generator, see binoxxo_random.h
 ///
 void
-bnx_randomize(struct Bnx const *);
+bnx_randomize(struct Bnx const *, struct BnxRandom *);
 
 ///
 /// \brief Copy data fields to another binoxxo 
@@ -149,23 +180,28 @@ void
 bnx_free(struct Bnx *);
 
 ///
-/// \brief Get a line from a binoxxo
+/// \brief Get a view on a line of a binoxxo
 ///
 /// \param Binoxxo data structure
 /// \param Line mode, horizontal or vertical
 /// \param Index
-/// \return Line data
+/// \param Line view to fill
 ///
-struct BnxLine *
-bnx_get_line(struct Bnx const *, const int, const int);
+void
+bnx_get_line(struct Bnx const *, const int, const int, struct BnxLine *);
 
 ///
-/// \brief Free memory used by a binoxxo line
+/// \brief Get a field of a line view
 ///
 /// \param Binoxxo line structure
+/// \param Index
+/// \return Pointer to the field
 ///
-void
-bnx_free_line(struct BnxLine *);
+static inline int *
+bnx_line_field(struct BnxLine const * const l, const size_t i)
+{
+	return &l->data[i * l->stride];
+}
 
 ///
 /// \brief Scan all lines with a callback function
@@ -210,6 +246,18 @@ bnx_line_count_empty(struct BnxLine const * const);
 int
 bnx_validate(struct Bnx const *);
 
+///
+/// \brief Search two equal complete lines
+///
+/// \param Binoxxo data structure
+/// \param Line mode, horizontal or vertical
+/// \param Index of the first line of a found pair
+/// \param Index of the second line of a found pair
+/// \return Error
+///
+int
+bnx_find_duplicate(struct Bnx const *, const int, int *, int *);
+
 ///
 /// \brief Return error number as string
 ///
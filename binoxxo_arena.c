@@ -0,0 +1,93 @@
+// 
+// binoxxo_arena.c
+// Copyright (C) 2014  Florian Tanner <florian.tanner@gmail.com>
+// 
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+// 
+
+
+
+#include <stdalign.h>
+#include <stdlib.h>
+
+#include "binoxxo_arena.h"
+
+///
+/// Header of a chunk, keeps the objects behind it aligned
+///
+union BnxArenaChunk {
+	void *next;
+	max_align_t align;
+};
+
+void
+bnx_arena_init(struct BnxArena *arena, const size_t object,
+               const size_t count)
+{
+	const size_t align = alignof(max_align_t);
+
+	// Returned objects hold the link of the free list
+	const size_t size = object < sizeof(void *) ? sizeof(void *) : object;
+
+	arena->object = (size + align - 1) / align * align;
+	arena->count  = count > 0 ? count : 1;
+	arena->chunk  = NULL;
+	arena->used   = 0;
+	arena->free   = NULL;
+}
+
+void *
+bnx_arena_get(struct BnxArena *arena)
+{
+	if (arena->free != NULL) {
+		void *object = arena->free;
+		arena->free = *(void **)object;
+		return object;
+	}
+
+	if (arena->chunk == NULL || arena->used == arena->count) {
+		union BnxArenaChunk *chunk = malloc(sizeof(union BnxArenaChunk)
+			+ arena->count * arena->object);
+		if (chunk == NULL) {
+			return NULL;
+		}
+		chunk->next  = arena->chunk;
+		arena->chunk = chunk;
+		arena->used  = 0;
+	}
+
+	char *objects = (char *)((union BnxArenaChunk *)arena->chunk + 1);
+
+	return objects + arena->object * arena->used++;
+}
+
+void
+bnx_arena_put(struct BnxArena *arena, void *object)
+{
+	*(void **)object = arena->free;
+	arena->free = object;
+}
+
+void
+bnx_arena_free(struct BnxArena *arena)
+{
+	while (arena->chunk != NULL) {
+		union BnxArenaChunk *chunk = arena->chunk;
+		arena->chunk = chunk->next;
+		free(chunk);
+	}
+
+	arena->used = 0;
+	arena->free = NULL;
+}
@@ -0,0 +1,76 @@
+// 
+// binoxxo_arena.h
+// Copyright (C) 2014  Florian Tanner <florian.tanner@gmail.com>
+// 
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+// 
+
+
+
+#ifndef BINOXXO_ARENA_H
+#define BINOXXO_ARENA_H
+
+#include <stddef.h>
+
+///
+/// Pool of objects of one size, allocated in chunks. Returned objects are
+/// reused, and all chunks are released at once by bnx_arena_free. An arena
+/// is not thread-safe.
+///
+struct BnxArena {
+	size_t object;					// Object size, rounded up to alignment
+	size_t count;					// Objects per chunk
+	void *chunk;					// Chunks, newest first
+	size_t used;					// Objects taken from the newest chunk
+	void *free;						// Returned objects
+};
+
+///
+/// \brief Initialize an empty arena, memory is allocated on first use
+///
+/// \param Arena
+/// \param Object size
+/// \param Objects per chunk
+///
+void
+bnx_arena_init(struct BnxArena *, const size_t, const size_t);
+
+///
+/// \brief Take an object from an arena
+///
+/// \param Arena
+/// \return Uninitialized object, NULL if no memory is left
+///
+void *
+bnx_arena_get(struct BnxArena *);
+
+///
+/// \brief Return an object for reuse. Objects may be returned to another
+/// 	arena of the same object size, if both arenas are released together.
+///
+/// \param Arena
+/// \param Object
+///
+void
+bnx_arena_put(struct BnxArena *, void *);
+
+///
+/// \brief Release all chunks of an arena, all of its objects become invalid
+///
+/// \param Arena
+///
+void
+bnx_arena_free(struct BnxArena *);
+
+#endif // BINOXXO_ARENA_H
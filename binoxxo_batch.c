@@ -0,0 +1,528 @@
+// 
+// binoxxo_batch.c
+// Copyright (C) 2014  Florian Tanner <florian.tanner@gmail.com>
+// 
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+// 
+
+
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <dirent.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "binoxxo_batch.h"
+
+///
+/// File extension of binoxxos picked up from directories
+///
+static const char bnx_batch_extension[] = ".binoxxo";
+
+///
+/// State shared by the threads solving a chunk
+///
+struct BnxBatchShared {
+	struct BnxBatch *batch;
+	atomic_size_t next;				// Next binoxxo to solve
+	int mode;
+	int sol_mode;
+};
+
+void
+bnx_batch_init(struct BnxBatch *batch)
+{
+	memset(batch, 0, sizeof(struct BnxBatch));
+}
+
+static int
+bnx_batch_add_input(struct BnxBatch *batch, const char *name, FILE *file)
+{
+	if (batch->inputs == batch->input_capacity) {
+		const size_t capacity = batch->input_capacity
+			? 2 * batch->input_capacity : 16;
+		struct BnxBatchInput *input = realloc(batch->input,
+			capacity * sizeof(struct BnxBatchInput));
+		if (input == NULL) {
+			fprintf(stderr, "Could not allocate memory for batch\n");
+			return -ENOMEM;
+		}
+		batch->input          = input;
+		batch->input_capacity = capacity;
+	}
+
+	char *copy = malloc(strlen(name) + 1);
+	if (copy == NULL) {
+		fprintf(stderr, "Could not allocate memory for batch\n");
+		return -ENOMEM;
+	}
+	strcpy(copy, name);
+
+	struct BnxBatchInput *input = &batch->input[batch->inputs++];
+	memset(input, 0, sizeof(struct BnxBatchInput));
+	input->name = copy;
+	input->file = file;
+	input->own  = file == NULL;
+
+	return 0;
+}
+
+int
+bnx_batch_add_stream(struct BnxBatch *batch, FILE *file, const char *name)
+{
+	return bnx_batch_add_input(batch, name, file);
+}
+
+static int
+bnx_batch_has_extension(const char *name)
+{
+	const size_t length = strlen(name);
+	const size_t extension = sizeof(bnx_batch_extension) - 1;
+
+	return length > extension
+		&& strcmp(name + length - extension, bnx_batch_extension) == 0;
+}
+
+static int
+bnx_batch_compare_names(const void *a, const void *b)
+{
+	return strcmp(*(char * const *)a, *(char * const *)b);
+}
+
+static int
+bnx_batch_add_dir(struct BnxBatch *batch, const char *path)
+{
+	DIR *dir = opendir(path);
+	if (!dir) {
+		fprintf(stderr, "Could not open directory %s\n", path);
+		return -ENOENT;
+	}
+
+	char **names = NULL;
+	size_t count = 0;
+	size_t capacity = 0;
+	struct dirent *entry;
+
+	while ((entry = readdir(dir)) != NULL) {
+		if (!bnx_batch_has_extension(entry->d_name)) {
+			continue;
+		}
+
+		if (count == capacity) {
+			capacity = capacity ? 2 * capacity : 64;
+			char **grown = realloc(names, capacity * sizeof(char *));
+			if (grown == NULL) {
+				break;
+			}
+			names = grown;
+		}
+
+		const size_t length = strlen(path) + strlen(entry->d_name) + 2;
+		names[count] = malloc(length);
+		if (names[count] == NULL) {
+			break;
+		}
+		snprintf(names[count], length, "%s/%s", path, entry->d_name);
+		count++;
+	}
+	closedir(dir);
+
+	// Directory order is arbitrary, keep runs reproducible
+	qsort(names, count, sizeof(char *), &bnx_batch_compare_names);
+
+	int error = 0;
+	size_t i;
+	for (i = 0; i < count; i++) {
+		if (error == 0) {
+			error = bnx_batch_add_input(batch, names[i], NULL);
+		}
+		free(names[i]);
+	}
+	free(names);
+
+	return error;
+}
+
+int
+bnx_batch_add_path(struct BnxBatch *batch, const char *path)
+{
+	struct stat info;
+
+	if (strcmp(path, "-") == 0) {
+		return bnx_batch_add_stream(batch, stdin, "stdin");
+	}
+
+	if (stat(path, &info) != 0) {
+		fprintf(stderr, "Could not open file %s\n", path);
+		return -ENOENT;
+	}
+
+	if (S_ISDIR(info.st_mode)) {
+		return bnx_batch_add_dir(batch, path);
+	}
+
+	return bnx_batch_add_input(batch, path, NULL);
+}
+
+int
+bnx_batch_add_list(struct BnxBatch *batch, const char *list)
+{
+	FILE *file = fopen(list, "r");
+	if (!file) {
+		fprintf(stderr, "Could not open list %s\n", list);
+		return -ENOENT;
+	}
+
+	int error = 0;
+	char *line = NULL;
+	size_t length = 0;
+	ssize_t read;
+
+	while (error == 0 && (read = getline(&line, &length, file)) != -1) {
+
+		// Strip the line break
+		while (read > 0 && isspace((unsigned char)line[read - 1])) {
+			line[--read] = '\0';
+		}
+		if (read > 0) {
+			error = bnx_batch_add_path(batch, line);
+		}
+	}
+
+	free(line);
+	fclose(file);
+
+	return error;
+}
+
+static void
+bnx_batch_close_input(struct BnxBatch *batch)
+{
+	struct BnxBatchInput *input = &batch->input[batch->current];
+
+	// Maps are kept until the binoxxos of the chunk are parsed
+	if (!input->mapped) {
+		bnx_reader_free(&batch->reader);
+	}
+	if (input->own && input->file != NULL) {
+		fclose(input->file);
+		input->file = NULL;
+	}
+
+	batch->reading  = false;
+	batch->position = 0;
+	batch->current++;
+}
+
+static int
+bnx_batch_open_input(struct BnxBatch *batch)
+{
+	struct BnxBatchInput *input = &batch->input[batch->current];
+
+	// Files are mapped and parsed by the solving threads, streams which can
+	// not be mapped are parsed while reading
+	if (input->own) {
+		const int error = bnx_map_open(&input->map, input->name);
+		if (error != -ENODEV) {
+			input->mapped = error == 0;
+			batch->reading = input->mapped;
+			return error;
+		}
+	}
+
+	if (input->file == NULL) {
+		input->file = fopen(input->name, "r");
+		if (input->file == NULL) {
+			fprintf(stderr, "Could not open file %s\n", input->name);
+			return -ENOENT;
+		}
+	}
+
+	if (bnx_reader_init(&batch->reader, input->file) != 0) {
+		return -ENOMEM;
+	}
+	batch->reading = true;
+
+	return 0;
+}
+
+static int
+bnx_batch_reserve(struct BnxBatch *batch, const size_t count)
+{
+	if (count <= batch->capacity) {
+		return 0;
+	}
+
+	struct BnxBatchItem *item = realloc(batch->item,
+		count * sizeof(struct BnxBatchItem));
+	if (item == NULL) {
+		fprintf(stderr, "Could not allocate memory for batch\n");
+		return -ENOMEM;
+	}
+
+	memset(item + batch->capacity, 0,
+	       (count - batch->capacity) * sizeof(struct BnxBatchItem));
+	batch->item     = item;
+	batch->capacity = count;
+
+	return 0;
+}
+
+size_t
+bnx_batch_read(struct BnxBatch *batch, const size_t max)
+{
+	size_t i;
+
+	for (i = 0; i < batch->count; i++) {
+		bnx_solution_free(batch->item[i].solution);
+		batch->item[i].solution = NULL;
+	}
+	batch->count = 0;
+
+	// Items of the last chunk were the only users of finished maps
+	for (; batch->closed < batch->current; batch->closed++) {
+		bnx_map_close(&batch->input[batch->closed].map);
+	}
+
+	if (bnx_batch_reserve(batch, max) != 0) {
+		return 0;
+	}
+
+	while (batch->count < max && batch->current < batch->inputs) {
+
+		if (!batch->reading) {
+			const int error = bnx_batch_open_input(batch);
+			if (error != 0) {
+				batch->error = batch->error ? batch->error : error;
+				batch->current++;
+				continue;
+			}
+		}
+
+		struct BnxBatchItem *item = &batch->item[batch->count];
+		struct BnxBatchInput const *input = &batch->input[batch->current];
+
+		if (input->mapped) {
+			if (batch->position == input->map.count) {
+				bnx_batch_close_input(batch);
+				continue;
+			}
+			item->input    = batch->current;
+			item->position = ++batch->position;
+			item->error    = 0;
+			batch->count++;
+			continue;
+		}
+
+		// Binoxxos with syntax errors are kept as failed items
+		item->puzzle = bnx_reader_next(&batch->reader, item->puzzle);
+		if (item->puzzle == NULL && batch->reader.error == 0) {
+			bnx_batch_close_input(batch);
+			continue;
+		}
+
+		item->input    = batch->current;
+		item->position = ++batch->position;
+		item->error    = batch->reader.error;
+		batch->count++;
+	}
+
+	return batch->count;
+}
+
+static void *
+bnx_batch_work(void *arg)
+{
+	struct BnxBatchShared *shared = arg;
+	struct BnxBatch *batch = shared->batch;
+	struct BnxSolverCtx *ctx = NULL;
+	size_t i;
+
+	while ((i = atomic_fetch_add(&shared->next, 1)) < batch->count) {
+
+		struct BnxBatchItem *item = &batch->item[i];
+		struct BnxBatchInput const *input = &batch->input[item->input];
+		struct BnxCollector collector;
+
+		if (item->error != 0) {
+			continue;
+		}
+
+		// Every thread parses its own slice of a map
+		if (input->mapped) {
+			item->puzzle = bnx_map_get(&input->map, item->position - 1,
+			                           item->puzzle);
+			if (item->puzzle == NULL) {
+				item->error = -EINVAL;
+				continue;
+			}
+		}
+
+		bnx_collector_init(&collector, shared->sol_mode);
+
+		// The context is allocated once and then reloaded
+		if (ctx == NULL) {
+			ctx = bnx_ctx_alloc(item->puzzle, shared->mode, &collector);
+			item->error = ctx != NULL ? 0 : -ENOMEM;
+		} else {
+			item->error = bnx_ctx_load(ctx, item->puzzle);
+		}
+
+		if (item->error == 0) {
+			ctx->collector = &collector;
+			bnx_solve_ctx(ctx);
+		}
+
+		item->solution = bnx_collector_destroy(&collector);
+	}
+
+	if (ctx != NULL) {
+		bnx_ctx_free(ctx);
+	}
+
+	return NULL;
+}
+
+void
+bnx_batch_solve(struct BnxBatch *batch, const int mode, const int sol_mode,
+                int threads)
+{
+	struct BnxBatchShared shared;
+	struct timespec start;
+	struct timespec end;
+
+	if (threads <= 0) {
+		threads = sysconf(_SC_NPROCESSORS_ONLN);
+		if (threads <= 0) {
+			threads = 1;
+		}
+	}
+
+	bnx_lines_init();
+
+	shared.batch    = batch;
+	shared.mode     = mode;
+	shared.sol_mode = sol_mode;
+	atomic_init(&shared.next, 0);
+
+	pthread_t *thread = malloc(sizeof(pthread_t) * threads);
+	if (thread == NULL) {
+		threads = 1;
+	}
+
+	timespec_get(&start, TIME_UTC);
+
+	int i;
+	int started = 0;
+	for (i = 1; i < threads; i++) {
+		if (pthread_create(&thread[started], NULL, &bnx_batch_work,
+		                   &shared) != 0) {
+			break;
+		}
+		started++;
+	}
+
+	// The calling thread works as well
+	bnx_batch_work(&shared);
+
+	for (i = 0; i < started; i++) {
+		pthread_join(thread[i], NULL);
+	}
+
+	timespec_get(&end, TIME_UTC);
+
+	free(thread);
+
+	size_t failed = 0;
+	for (i = 0; i < batch->count; i++) {
+		const int error = batch->item[i].error;
+		if (error != 0) {
+			batch->error = batch->error ? batch->error : error;
+			failed++;
+		}
+	}
+
+	batch->solved  += batch->count - failed;
+	batch->seconds += (double)(end.tv_sec - start.tv_sec)
+		+ (double)(end.tv_nsec - start.tv_nsec) / 1e9;
+}
+
+void
+bnx_batch_print(struct BnxBatch const * const batch)
+{
+	size_t i;
+
+	for (i = 0; i < batch->count; i++) {
+
+		struct BnxBatchItem const *item = &batch->item[i];
+		const char *name = batch->input[item->input].name;
+
+		if (item->error != 0) {
+			fprintf(stderr, "%s:%zu: Could not solve binoxxo: %s\n", name,
+			        item->position, strerror(-item->error));
+			continue;
+		}
+
+		printf("%s:%zu\n", name, item->position);
+
+		struct BnxSolution *ps = item->solution;
+		if (ps == NULL) {
+			puts("No solution");
+		}
+		while (ps) {
+			bnx_print(ps->data);
+			ps = ps->next;
+		}
+	}
+}
+
+int
+bnx_batch_run(struct BnxBatch *batch, const int mode, const int sol_mode,
+              const int threads)
+{
+	while (bnx_batch_read(batch, BNX_BATCH_CHUNK) > 0) {
+		bnx_batch_solve(batch, mode, sol_mode, threads);
+		bnx_batch_print(batch);
+	}
+
+	return batch->error;
+}
+
+void
+bnx_batch_free(struct BnxBatch *batch)
+{
+	size_t i;
+
+	if (batch->reading) {
+		bnx_batch_close_input(batch);
+	}
+
+	for (i = 0; i < batch->capacity; i++) {
+		bnx_free(batch->item[i].puzzle);
+		bnx_solution_free(batch->item[i].solution);
+	}
+
+	for (i = 0; i < batch->inputs; i++) {
+		if (batch->input[i].own && batch->input[i].file != NULL) {
+			fclose(batch->input[i].file);
+		}
+		bnx_map_close(&batch->input[i].map);
+		free(batch->input[i].name);
+	}
+
+	free(batch->item);
+	free(batch->input);
+	bnx_batch_init(batch);
+}
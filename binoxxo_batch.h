@@ -0,0 +1,170 @@
+// 
+// binoxxo_batch.h
+// Copyright (C) 2014  Florian Tanner <florian.tanner@gmail.com>
+// 
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+// 
+
+
+
+#ifndef BINOXXO_BATCH_H
+#define BINOXXO_BATCH_H
+
+#include "binoxxo.h"
+#include "binoxxo_io.h"
+#include "binoxxo_solver.h"
+
+///
+/// Number of binoxxos read and solved at once by bnx_batch_run
+///
+#define BNX_BATCH_CHUNK 4096
+
+///
+/// Source of binoxxos of a batch
+///
+struct BnxBatchInput {
+	char *name;
+	FILE *file;						// Opened when reading starts
+	int own;						// File is closed by the batch
+	struct BnxMap map;				// Regular files are mapped instead
+	int mapped;
+};
+
+///
+/// Binoxxo of a batch together with its origin and solutions
+///
+struct BnxBatchItem {
+	size_t input;					// Index of the input
+	size_t position;				// Position inside the input, from 1
+	struct Bnx *puzzle;
+	struct BnxSolution *solution;
+	int error;						// Error of reading or solving
+};
+
+///
+/// Binoxxos solved together, read chunk by chunk from a queue of inputs
+/// and kept in input order
+///
+struct BnxBatch {
+	struct BnxBatchItem *item;		// Current chunk
+	size_t count;
+	size_t capacity;
+	struct BnxBatchInput *input;
+	size_t inputs;
+	size_t input_capacity;
+	size_t current;					// Input being read
+	size_t closed;					// Inputs before have their maps closed
+	size_t position;				// Binoxxos read from the current input
+	struct BnxReader reader;
+	int reading;					// Reader is open on the current input
+	size_t solved;					// Binoxxos solved in all chunks
+	double seconds;					// Wall time of all solves
+	int error;						// First error of inputs and binoxxos
+};
+
+///
+/// \brief Initialize an empty batch
+///
+/// \param Batch
+///
+void
+bnx_batch_init(struct BnxBatch *);
+
+///
+/// \brief Queue an open stream, it is not closed by the batch
+///
+/// \param Batch
+/// \param Stream
+/// \param Name of the stream
+/// \return Error
+///
+int
+bnx_batch_add_stream(struct BnxBatch *, FILE *, const char *);
+
+///
+/// \brief Queue a path. A directory queues all its *.binoxxo files in
+/// 	sorted order, a file may hold several binoxxos and "-" is stdin.
+///
+/// \param Batch
+/// \param Path
+/// \return Error, -ENOENT if the path does not exist
+///
+int
+bnx_batch_add_path(struct BnxBatch *, const char *);
+
+///
+/// \brief Queue all paths listed in a file, one per line
+///
+/// \param Batch
+/// \param List file
+/// \return Error
+///
+int
+bnx_batch_add_list(struct BnxBatch *, const char *);
+
+///
+/// \brief Replace the current chunk with the next binoxxos of the inputs.
+/// 	Binoxxos of the last chunk are reused if the size matches.
+///
+/// \param Batch
+/// \param Maximal number of binoxxos
+/// \return Number of binoxxos read, 0 once all inputs are exhausted
+///
+size_t
+bnx_batch_read(struct BnxBatch *, const size_t);
+
+///
+/// \brief Solve all binoxxos of the current chunk. Every thread reuses one
+/// 	solver context and takes the next unsolved binoxxo until none is
+/// 	left. Binoxxos which fail to load keep their error and are not
+/// 	counted as solved.
+///
+/// \param Batch
+/// \param Guess mode
+/// \param Solution mode
+/// \param Number of threads, 0 for one per processor
+///
+void
+bnx_batch_solve(struct BnxBatch *, const int, const int, int);
+
+///
+/// \brief Print the solutions of the current chunk in input order, and
+/// 	the errors of failed binoxxos to stderr
+///
+/// \param Batch
+///
+void
+bnx_batch_print(struct BnxBatch const * const);
+
+///
+/// \brief Read, solve and print all inputs chunk by chunk
+///
+/// \param Batch
+/// \param Guess mode
+/// \param Solution mode
+/// \param Number of threads, 0 for one per processor
+/// \return First error of all inputs and binoxxos
+///
+int
+bnx_batch_run(struct BnxBatch *, const int, const int, const int);
+
+///
+/// \brief Free all binoxxos, solutions and inputs of a batch
+///
+/// \param Batch
+///
+void
+bnx_batch_free(struct BnxBatch *);
+
+#endif // BINOXXO_BATCH_H
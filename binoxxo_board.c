@@ -0,0 +1,448 @@
+// 
+// binoxxo_board.c
+// Copyright (C) 2014  Florian Tanner <florian.tanner@gmail.com>
+// 
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+// 
+
+
+#include "binoxxo_board.h"
+#include "binoxxo_simd.h"
+
+///
+/// Trail entries hold the field index and this flag for o's
+///
+#define BNX_TRAIL_O 0x8000
+
+///
+/// Number of changed lines of a direction from which bnx_check_lines checks
+/// the whole direction instead of the changed lines one by one
+///
+#define BNX_BOARD_CHECK_ALL 8
+
+void
+bnx_board_init(struct BnxBoard *board, const size_t size)
+{
+	// Leave the trail uninitialized, it is only read up to its size
+	memset(board, 0, offsetof(struct BnxBoard, trail));
+
+	board->size = size;
+	if (size < BNX_MAX_SIZE) {
+		board->full = ((BnxMask)1 << size) - 1;
+	} else {
+		board->full = ~(BnxMask)0;
+	}
+
+	// Nothing propagated and validated yet
+	board->queue[BNX_DIR_H] = board->full;
+	board->queue[BNX_DIR_V] = board->full;
+	board->dirty[BNX_DIR_H] = board->full;
+	board->dirty[BNX_DIR_V] = board->full;
+}
+
+void
+bnx_board_copy(struct BnxBoard *dest, struct BnxBoard const * const src)
+{
+	memcpy(dest, src, offsetof(struct BnxBoard, trail));
+	dest->trail_size = 0;
+}
+
+int
+bnx_board_pack(struct BnxBoard *board, struct Bnx const * const b)
+{
+	if (b == NULL || b->size > BNX_MAX_SIZE) {
+		return -EINVAL;
+	}
+
+	bnx_board_init(board, b->size);
+
+	const size_t size = b->size;
+	int row;
+	int col;
+	for (row = 0; row < size; row++) {
+		for (col = 0; col < size; col++) {
+			const int field = b->data[row][col];
+			if (field == BNX_FIELD_O || field == BNX_FIELD_X) {
+				bnx_board_set(board, row, col, field);
+			}
+		}
+	}
+
+	return 0;
+}
+
+int
+bnx_board_unpack(struct Bnx const *b, struct BnxBoard const * const board)
+{
+	if (b == NULL || b->size != board->size) {
+		return -EINVAL;
+	}
+
+	const size_t size = board->size;
+	int row;
+	for (row = 0; row < size; row++) {
+		const BnxMask o = board->o[BNX_DIR_H][row];
+		const BnxMask x = board->x[BNX_DIR_H][row];
+		int col;
+		for (col = 0; col < size; col++) {
+			const BnxMask bit = (BnxMask)1 << col;
+			if (o & bit) {
+				b->data[row][col] = BNX_FIELD_O;
+			} else if (x & bit) {
+				b->data[row][col] = BNX_FIELD_X;
+			} else {
+				b->data[row][col] = BNX_FIELD_EMPTY;
+			}
+		}
+	}
+
+	return 0;
+}
+
+int
+bnx_board_get(struct BnxBoard const * const board, const int row,
+              const int col)
+{
+	const BnxMask bit = (BnxMask)1 << col;
+
+	if (board->o[BNX_DIR_H][row] & bit) {
+		return BNX_FIELD_O;
+	}
+	if (board->x[BNX_DIR_H][row] & bit) {
+		return BNX_FIELD_X;
+	}
+	return BNX_FIELD_EMPTY;
+}
+
+void
+bnx_board_set(struct BnxBoard *board, const int row, const int col,
+              const int field)
+{
+	BnxMask (*mask)[BNX_MAX_SIZE] = board->x;
+	unsigned char (*count)[BNX_MAX_SIZE] = board->count_x;
+	if (field == BNX_FIELD_O) {
+		mask  = board->o;
+		count = board->count_o;
+	}
+
+	const BnxMask bit = (BnxMask)1 << col;
+	if (mask[BNX_DIR_H][row] & bit) {
+		return;
+	}
+
+	mask[BNX_DIR_H][row] |= bit;
+	mask[BNX_DIR_V][col] |= (BnxMask)1 << row;
+	count[BNX_DIR_H][row]++;
+	count[BNX_DIR_V][col]++;
+
+	unsigned short entry = row * BNX_MAX_SIZE + col;
+	if (field == BNX_FIELD_O) {
+		entry |= BNX_TRAIL_O;
+	}
+	board->trail[board->trail_size++] = entry;
+
+	board->queue[BNX_DIR_H] |= (BnxMask)1 << row;
+	board->queue[BNX_DIR_V] |= (BnxMask)1 << col;
+	board->dirty[BNX_DIR_H] |= (BnxMask)1 << row;
+	board->dirty[BNX_DIR_V] |= (BnxMask)1 << col;
+}
+
+size_t
+bnx_board_mark(struct BnxBoard const * const board)
+{
+	return board->trail_size;
+}
+
+void
+bnx_board_undo(struct BnxBoard *board, const size_t mark)
+{
+	while (board->trail_size > mark) {
+
+		const unsigned short entry = board->trail[--board->trail_size];
+		const int row = (entry & ~BNX_TRAIL_O) / BNX_MAX_SIZE;
+		const int col = (entry & ~BNX_TRAIL_O) % BNX_MAX_SIZE;
+
+		BnxMask (*mask)[BNX_MAX_SIZE] = board->x;
+		unsigned char (*count)[BNX_MAX_SIZE] = board->count_x;
+		if (entry & BNX_TRAIL_O) {
+			mask  = board->o;
+			count = board->count_o;
+		}
+
+		mask[BNX_DIR_H][row] &= ~((BnxMask)1 << col);
+		mask[BNX_DIR_V][col] &= ~((BnxMask)1 << row);
+		count[BNX_DIR_H][row]--;
+		count[BNX_DIR_V][col]--;
+
+		board->dirty[BNX_DIR_H] |= (BnxMask)1 << row;
+		board->dirty[BNX_DIR_V] |= (BnxMask)1 << col;
+	}
+
+	board->queue[BNX_DIR_H] = 0;
+	board->queue[BNX_DIR_V] = 0;
+}
+
+void
+bnx_board_get_line(struct BnxBoard const * const board, const int dir,
+                   const int index, struct BnxBits *line)
+{
+	line->size = board->size;
+	line->full = board->full;
+	line->o    = board->o[dir][index];
+	line->x    = board->x[dir][index];
+}
+
+BnxMask
+bnx_board_empty(struct BnxBoard const * const board, const int dir,
+                const int index)
+{
+	return board->full & ~(board->o[dir][index] | board->x[dir][index]);
+}
+
+static void
+bnx_board_add(struct BnxBoard *board, const int dir, const int index,
+              BnxMask added, const int field)
+{
+	while (added) {
+		const int i = bnx_mask_first(added);
+		added &= added - 1;
+
+		if (dir == BNX_DIR_H) {
+			bnx_board_set(board, index, i, field);
+		} else {
+			bnx_board_set(board, i, index, field);
+		}
+	}
+}
+
+int
+bnx_board_pop(struct BnxBoard *board, int *dir, int *index)
+{
+	int d;
+	for (d = BNX_DIR_H; d <= BNX_DIR_V; d++) {
+		if (board->queue[d]) {
+			*dir   = d;
+			*index = bnx_mask_first(board->queue[d]);
+			board->queue[d] &= board->queue[d] - 1;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+void
+bnx_board_put_line(struct BnxBoard *board, const int dir, const int index,
+                   struct BnxBits const * const line)
+{
+	bnx_board_add(board, dir, index, line->o & ~board->o[dir][index],
+	              BNX_FIELD_O);
+	bnx_board_add(board, dir, index, line->x & ~board->x[dir][index],
+	              BNX_FIELD_X);
+
+	board->queue[dir] &= ~((BnxMask)1 << index);
+}
+
+static int
+bnx_bits_has_triple(const BnxMask m)
+{
+	return (m & (m >> 1) & (m >> 2)) != 0;
+}
+
+int
+bnx_bits_validate(struct BnxBits const * const line)
+{
+	const int half = line->size / 2;
+	int error = BNX_CORRECT;
+
+	if ((line->o | line->x) != line->full) {
+		error |= BNX_ERR_FILL;
+	}
+
+	if (line->o & line->x) {
+		error |= BNX_ERR_CONFLICT;
+	}
+
+	if (bnx_bits_has_triple(line->o) || bnx_bits_has_triple(line->x)) {
+		error |= BNX_ERR_FOLLOW;
+	}
+
+	if (bnx_mask_count(line->o) > half || bnx_mask_count(line->x) > half) {
+		error |= BNX_ERR_BALANCE;
+	}
+
+	return error;
+}
+
+///
+/// Hash set used for the uniqueness check, has at least twice as many
+/// slots as a board has lines
+///
+#define BNX_UNIQUE_BITS 7
+#define BNX_UNIQUE_SLOTS (1 << BNX_UNIQUE_BITS)
+
+static unsigned int
+bnx_board_hash(const BnxMask fingerprint)
+{
+	// Fibonacci hashing, keep the top bits of the product
+	return (fingerprint * 0x9E3779B97F4A7C15ull) >> (64 - BNX_UNIQUE_BITS);
+}
+
+int
+bnx_board_find_duplicate(struct BnxBoard const * const board, const int dir,
+                         int *first, int *second)
+{
+	const size_t size = board->size;
+	const BnxMask full = board->full;
+	unsigned char slot[BNX_UNIQUE_SLOTS] = { 0 };	// Line index + 1
+	int i;
+
+	for (i = 0; i < size; i++) {
+
+		const BnxMask o = board->o[dir][i];
+		const BnxMask x = board->x[dir][i];
+
+		// Only complete lines take part, their x's are the fingerprint
+		if ((o | x) != full) {
+			continue;
+		}
+
+		unsigned int h = bnx_board_hash(x);
+		while (slot[h]) {
+			const int j = slot[h] - 1;
+			if (board->x[dir][j] == x && board->o[dir][j] == o) {
+				if (first != NULL) {
+					*first = j;
+				}
+				if (second != NULL) {
+					*second = i;
+				}
+				return BNX_ERR_UNIQUE;
+			}
+			h = (h + 1) % BNX_UNIQUE_SLOTS;
+		}
+		slot[h] = i + 1;
+	}
+
+	return BNX_CORRECT;
+}
+
+int
+bnx_board_validate(struct BnxBoard const * const board)
+{
+	int dir;
+	int error = BNX_CORRECT;
+	struct BnxCheck check;
+
+	for (dir = BNX_DIR_H; dir <= BNX_DIR_V; dir++) {
+		bnx_check_lines(board, dir, &check);
+
+		error |= (check.fill ? BNX_ERR_FILL : 0)
+			| (check.conflict ? BNX_ERR_CONFLICT : 0)
+			| (check.follow ? BNX_ERR_FOLLOW : 0)
+			| (check.balance ? BNX_ERR_BALANCE : 0)
+			| bnx_board_find_duplicate(board, dir, NULL, NULL);
+	}
+
+	return error;
+}
+
+///
+/// \brief Check the line rules of some lines of a direction
+///
+/// \param Board
+/// \param Direction
+/// \param Lines to check
+/// \param Result, bits of other lines stay 0
+///
+static void
+bnx_board_check_some(struct BnxBoard const * const board, const int dir,
+                     BnxMask lines, struct BnxCheck *check)
+{
+	const int half = board->size / 2;
+
+	memset(check, 0, sizeof(struct BnxCheck));
+
+	while (lines) {
+		const int i = bnx_mask_first(lines);
+		const BnxMask bit = (BnxMask)1 << i;
+		const BnxMask o = board->o[dir][i];
+		const BnxMask x = board->x[dir][i];
+		lines &= lines - 1;
+
+		if ((o | x) != board->full) {
+			check->fill |= bit;
+		}
+		if (o & x) {
+			check->conflict |= bit;
+		}
+		if (bnx_bits_has_triple(o) || bnx_bits_has_triple(x)) {
+			check->follow |= bit;
+		}
+		if (board->count_o[dir][i] > half || board->count_x[dir][i] > half) {
+			check->balance |= bit;
+		}
+	}
+}
+
+int
+bnx_board_validate_dirty(struct BnxBoard *board)
+{
+	int dir;
+	int error = BNX_CORRECT;
+
+	for (dir = BNX_DIR_H; dir <= BNX_DIR_V; dir++) {
+
+		const BnxMask dirty = board->dirty[dir];
+
+		if (dirty) {
+			struct BnxCheck check;
+			if (bnx_mask_count(dirty) < BNX_BOARD_CHECK_ALL) {
+				bnx_board_check_some(board, dir, dirty, &check);
+			} else {
+				bnx_check_lines(board, dir, &check);
+			}
+
+			// Only the results of changed lines are replaced
+			const BnxMask clean = ~dirty;
+			board->open[dir] = (board->open[dir] & clean)
+				| (check.fill & dirty);
+			board->conflict[dir] = (board->conflict[dir] & clean)
+				| (check.conflict & dirty);
+			board->follow[dir] = (board->follow[dir] & clean)
+				| (check.follow & dirty);
+			board->balance[dir] = (board->balance[dir] & clean)
+				| (check.balance & dirty);
+
+			// A duplicate can only appear with a newly completed line and
+			// only disappear with a changed line
+			if ((dirty & ~check.fill) || board->unique[dir]) {
+				board->unique[dir] = bnx_board_find_duplicate(board, dir,
+				                                              NULL, NULL);
+			}
+			board->dirty[dir] = 0;
+		}
+
+		error |= (board->conflict[dir] ? BNX_ERR_CONFLICT : 0)
+			| (board->follow[dir] ? BNX_ERR_FOLLOW : 0)
+			| (board->balance[dir] ? BNX_ERR_BALANCE : 0)
+			| board->unique[dir];
+
+		if (board->open[dir]) {
+			error |= BNX_ERR_FILL;
+		}
+	}
+
+	return error;
+}
@@ -0,0 +1,296 @@
+// 
+// binoxxo_board.h
+// Copyright (C) 2014  Florian Tanner <florian.tanner@gmail.com>
+// 
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+// 
+
+
+#ifndef BINOXXO_BOARD_H
+#define BINOXXO_BOARD_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "binoxxo.h"
+
+///
+/// Bitmask with one bit per field of a line
+///
+typedef uint64_t BnxMask;
+
+///
+/// Line direction, used as index into the masks of a board
+///
+enum BnxDir {
+	BNX_DIR_H = 0,
+	BNX_DIR_V = 1,
+};
+
+///
+/// Packed binoxxo used by the solver
+/// Every line is stored twice, as row and as column, with one mask for the
+/// o's and one for the x's. Bit i of a row is column i, bit i of a column
+/// is row i.
+///
+struct BnxBoard {
+	size_t size;
+	BnxMask full;						// All fields of a line set
+	BnxMask o[2][BNX_MAX_SIZE];			// Indexed by direction and line
+	BnxMask x[2][BNX_MAX_SIZE];
+	unsigned char count_o[2][BNX_MAX_SIZE];	// Running counts per line
+	unsigned char count_x[2][BNX_MAX_SIZE];
+	BnxMask queue[2];					// Lines waiting for propagation
+	BnxMask dirty[2];					// Lines changed since last validation
+	BnxMask open[2];					// Lines with empty fields
+	BnxMask conflict[2];				// Lines with errors of last validation
+	BnxMask follow[2];
+	BnxMask balance[2];
+	int unique[2];						// Uniqueness of last validation
+	size_t trail_size;
+	unsigned short trail[BNX_MAX_SIZE * BNX_MAX_SIZE];	// Set fields in order
+};
+
+///
+/// Copy of a single board line
+///
+struct BnxBits {
+	size_t size;
+	BnxMask full;
+	BnxMask o;
+	BnxMask x;
+};
+
+///
+/// Function pointer for a board scanner function
+/// Takes as argument a line which it may modify
+/// Returns modification status
+///
+typedef int
+(*BnxBitsScannerFnc)(struct BnxBits *);
+
+///
+/// \brief Count set bits
+///
+/// \param Mask
+/// \return Number of set bits
+///
+static inline int
+bnx_mask_count(const BnxMask m)
+{
+	return __builtin_popcountll(m);
+}
+
+///
+/// \brief Index of the lowest set bit
+///
+/// \param Mask, must not be zero
+/// \return Index
+///
+static inline int
+bnx_mask_first(const BnxMask m)
+{
+	return __builtin_ctzll(m);
+}
+
+///
+/// \brief Initialize an empty board
+///
+/// \param Board
+/// \param Size
+///
+void
+bnx_board_init(struct BnxBoard *, const size_t);
+
+///
+/// \brief Copy a board without its trail, fields of the source can not be
+/// 	undone in the copy
+///
+/// \param Destination
+/// \param Source
+///
+void
+bnx_board_copy(struct BnxBoard *, struct BnxBoard const * const);
+
+///
+/// \brief Pack a binoxxo matrix into a board
+///
+/// \param Board
+/// \param Binoxxo data structure
+/// \return Error
+///
+int
+bnx_board_pack(struct BnxBoard *, struct Bnx const * const);
+
+///
+/// \brief Unpack a board into a binoxxo matrix of the same size
+///
+/// \param Binoxxo data structure
+/// \param Board
+/// \return Error
+///
+int
+bnx_board_unpack(struct Bnx const *, struct BnxBoard const * const);
+
+///
+/// \brief Get the value of a field
+///
+/// \param Board
+/// \param Row
+/// \param Column
+/// \return Field value
+///
+int
+bnx_board_get(struct BnxBoard const * const, const int, const int);
+
+///
+/// \brief Set an empty field, updates the line counts and marks its row
+/// 	and column dirty and queued
+///
+/// \param Board
+/// \param Row
+/// \param Column
+/// \param Field value
+///
+void
+bnx_board_set(struct BnxBoard *, const int, const int, const int);
+
+///
+/// \brief Get a mark of the current state, to which a board can be
+/// 	reverted with bnx_board_undo
+///
+/// \param Board
+/// \return Mark
+///
+size_t
+bnx_board_mark(struct BnxBoard const * const);
+
+///
+/// \brief Clear all fields set since a mark was taken. Queued lines are
+/// 	dropped, so marks should be taken when the queue is empty.
+///
+/// \param Board
+/// \param Mark
+///
+void
+bnx_board_undo(struct BnxBoard *, const size_t);
+
+///
+/// \brief Copy a line out of a board
+///
+/// \param Board
+/// \param Direction
+/// \param Index
+/// \param Line
+///
+void
+bnx_board_get_line(struct BnxBoard const * const, const int, const int,
+                   struct BnxBits *);
+
+///
+/// \brief Mask of empty fields of a line
+///
+/// \param Board
+/// \param Direction
+/// \param Index
+/// \return Mask
+///
+BnxMask
+bnx_board_empty(struct BnxBoard const * const, const int, const int);
+
+///
+/// \brief Number of empty fields of a line
+///
+/// \param Board
+/// \param Direction
+/// \param Index
+/// \return Number of empty fields
+///
+static inline int
+bnx_board_count_empty(struct BnxBoard const * const board, const int dir,
+                      const int index)
+{
+	return board->size - board->count_o[dir][index]
+		- board->count_x[dir][index];
+}
+
+///
+/// \brief Take a line from the propagation queue
+///
+/// \param Board
+/// \param Direction of the taken line
+/// \param Index of the taken line
+/// \return True if a line was taken, false if the queue is empty
+///
+int
+bnx_board_pop(struct BnxBoard *, int *, int *);
+
+///
+/// \brief Write back the fields a scanner added to a line. Crossing lines
+/// 	of added fields are queued, the line itself is not.
+///
+/// \param Board
+/// \param Direction
+/// \param Index
+/// \param Line
+///
+void
+bnx_board_put_line(struct BnxBoard *, const int, const int,
+                   struct BnxBits const * const);
+
+///
+/// \brief Validate the triple and balance rules of a single line
+///
+/// \param Line
+/// \return Error
+///
+int
+bnx_bits_validate(struct BnxBits const * const);
+
+///
+/// \brief Search two equal complete lines using a hash set of their
+/// 	fingerprints
+///
+/// \param Board
+/// \param Direction
+/// \param Index of the first line of a found pair, may be NULL
+/// \param Index of the second line of a found pair, may be NULL
+/// \return Error
+///
+int
+bnx_board_find_duplicate(struct BnxBoard const * const, const int, int *,
+                         int *);
+
+///
+/// \brief Validate all rules of a board, see bnx_validate
+///
+/// \param Board
+/// \return Error
+///
+int
+bnx_board_validate(struct BnxBoard const * const);
+
+///
+/// \brief Validate all rules of a board, but only re-check the lines
+/// 	changed since the last call. Results of clean lines are cached in
+/// 	the board. With many changed lines in a direction, bnx_check_lines
+/// 	checks all of them at once.
+///
+/// \param Board
+/// \return Error
+///
+int
+bnx_board_validate_dirty(struct BnxBoard *);
+
+#endif // BINOXXO_BOARD_H
@@ -0,0 +1,433 @@
+// 
+// binoxxo_cache.c
+// Copyright (C) 2014  Florian Tanner <florian.tanner@gmail.com>
+// 
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+// 
+
+
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <unistd.h>
+
+#include "binoxxo_cache.h"
+#include "binoxxo_io.h"
+#include "binoxxo_symmetry.h"
+
+///
+/// Comment at the start of a cache file
+///
+#define BNX_CACHE_HEADER "# binoxxo solve cache: complete count, " \
+	"key, solutions\n"
+
+int
+bnx_cache_init(struct BnxCache *cache, const size_t capacity)
+{
+	memset(cache, 0, sizeof(struct BnxCache));
+
+	// Keep chains short, at most half of the buckets are used
+	cache->capacity = capacity;
+	cache->buckets  = 1;
+	while (cache->buckets < 2 * capacity) {
+		cache->buckets *= 2;
+	}
+
+	cache->bucket = calloc(cache->buckets, sizeof(struct BnxCacheEntry *));
+	if (cache->bucket == NULL) {
+		fprintf(stderr, "Could not allocate memory for cache\n");
+		return -ENOMEM;
+	}
+
+	pthread_mutex_init(&cache->lock, NULL);
+
+	return 0;
+}
+
+///
+/// \brief FNV-1a hash of the size and the fields of a binoxxo
+///
+static uint64_t
+bnx_cache_hash(struct Bnx const * const b)
+{
+	const uint64_t prime = 0x100000001B3ull;
+	uint64_t hash = (0xCBF29CE484222325ull ^ b->size) * prime;
+	size_t i;
+
+	for (i = 0; i < b->size * b->size; i++) {
+		hash = (hash ^ (uint64_t)(b->data[0][i] & 0xFF)) * prime;
+	}
+
+	return hash;
+}
+
+static struct BnxCacheEntry **
+bnx_cache_bucket(struct BnxCache *cache, const uint64_t hash)
+{
+	return &cache->bucket[hash & (cache->buckets - 1)];
+}
+
+static struct BnxCacheEntry *
+bnx_cache_find(struct BnxCache *cache, struct Bnx const * const key,
+               const uint64_t hash)
+{
+	struct BnxCacheEntry *entry = *bnx_cache_bucket(cache, hash);
+
+	for (; entry != NULL; entry = entry->chain) {
+		if (entry->hash == hash && entry->key->size == key->size
+		    && memcmp(entry->key->data[0], key->data[0],
+		              key->size * key->size * sizeof(int)) == 0) {
+			return entry;
+		}
+	}
+
+	return NULL;
+}
+
+///
+/// \brief Take an entry out of the order of use
+///
+static void
+bnx_cache_unlink(struct BnxCache *cache, struct BnxCacheEntry *entry)
+{
+	if (entry->newer != NULL) {
+		entry->newer->older = entry->older;
+	} else {
+		cache->newest = entry->older;
+	}
+	if (entry->older != NULL) {
+		entry->older->newer = entry->newer;
+	} else {
+		cache->oldest = entry->newer;
+	}
+	entry->newer = NULL;
+	entry->older = NULL;
+}
+
+///
+/// \brief Make an entry the most recently used one
+///
+static void
+bnx_cache_push(struct BnxCache *cache, struct BnxCacheEntry *entry)
+{
+	entry->older = cache->newest;
+	entry->newer = NULL;
+	if (cache->newest != NULL) {
+		cache->newest->newer = entry;
+	} else {
+		cache->oldest = entry;
+	}
+	cache->newest = entry;
+}
+
+static void
+bnx_cache_entry_free(struct BnxCacheEntry *entry)
+{
+	size_t i;
+
+	for (i = 0; i < entry->count; i++) {
+		bnx_free(entry->solution[i]);
+	}
+	free(entry->solution);
+	bnx_free(entry->key);
+	free(entry);
+}
+
+static void
+bnx_cache_remove(struct BnxCache *cache, struct BnxCacheEntry *entry)
+{
+	struct BnxCacheEntry **link = bnx_cache_bucket(cache, entry->hash);
+
+	while (*link != entry) {
+		link = &(*link)->chain;
+	}
+	*link = entry->chain;
+
+	bnx_cache_unlink(cache, entry);
+	bnx_cache_entry_free(entry);
+	cache->count--;
+}
+
+int
+bnx_cache_get(struct BnxCache *cache, struct Bnx const * const b,
+              const int sol_mode, struct BnxSolution **solution)
+{
+	struct Bnx *key = bnx_alloc(b->size);
+	struct Bnx *mapped = bnx_alloc(b->size);
+	int hit = false;
+
+	if (key == NULL || mapped == NULL) {
+		bnx_free(key);
+		bnx_free(mapped);
+		return false;
+	}
+
+	const int inverse = bnx_symmetry_inverse(bnx_canonical(key, b));
+	const uint64_t hash = bnx_cache_hash(key);
+
+	pthread_mutex_lock(&cache->lock);
+
+	struct BnxCacheEntry *entry = bnx_cache_find(cache, key, hash);
+
+	// Entries of a search for fewer solutions may not do
+	if (entry != NULL && (entry->complete
+	    || (sol_mode != BNX_SOLUTION_MODE_ALL
+	        && (size_t)sol_mode <= entry->count))) {
+
+		size_t count = entry->count;
+		if (sol_mode != BNX_SOLUTION_MODE_ALL && (size_t)sol_mode < count) {
+			count = sol_mode;
+		}
+
+		// Pushing from the back keeps the order of the entry
+		struct BnxSolution *list = NULL;
+		hit = true;
+		while (count-- > 0 && hit) {
+			bnx_symmetry_apply(mapped, entry->solution[count], inverse);
+			hit = bnx_visitor_list(mapped, &list);
+		}
+
+		if (hit) {
+			*solution = list;
+			bnx_cache_unlink(cache, entry);
+			bnx_cache_push(cache, entry);
+		} else {
+			bnx_solution_free(list);
+		}
+	}
+
+	if (hit) {
+		cache->hits++;
+	} else {
+		cache->misses++;
+	}
+
+	pthread_mutex_unlock(&cache->lock);
+
+	bnx_free(key);
+	bnx_free(mapped);
+
+	return hit;
+}
+
+int
+bnx_cache_put(struct BnxCache *cache, struct Bnx const * const b,
+              const int sol_mode, struct BnxSolution const *solution)
+{
+	struct BnxSolution const *s;
+	size_t count = 0;
+
+	if (cache->capacity == 0) {
+		return 0;
+	}
+
+	for (s = solution; s != NULL; s = s->next) {
+		if (s->data->size != b->size) {
+			return -EINVAL;
+		}
+		count++;
+	}
+
+	// Solutions are stored in the orientation of the key
+	struct BnxCacheEntry *entry = calloc(1, sizeof(struct BnxCacheEntry));
+	if (entry == NULL
+	    || (entry->solution = calloc(count + 1, sizeof(struct Bnx *))) == NULL
+	    || (entry->key = bnx_alloc(b->size)) == NULL) {
+		fprintf(stderr, "Could not allocate memory for cache\n");
+		if (entry != NULL) {
+			bnx_cache_entry_free(entry);
+		}
+		return -ENOMEM;
+	}
+
+	const int sym = bnx_canonical(entry->key, b);
+	entry->hash     = bnx_cache_hash(entry->key);
+	entry->complete = sol_mode == BNX_SOLUTION_MODE_ALL
+		|| count < (size_t)sol_mode;
+
+	for (s = solution; s != NULL; s = s->next) {
+		struct Bnx *copy = bnx_alloc(b->size);
+		if (copy == NULL) {
+			bnx_cache_entry_free(entry);
+			return -ENOMEM;
+		}
+		bnx_symmetry_apply(copy, s->data, sym);
+		entry->solution[entry->count++] = copy;
+	}
+
+	pthread_mutex_lock(&cache->lock);
+
+	struct BnxCacheEntry *old = bnx_cache_find(cache, entry->key,
+	                                           entry->hash);
+
+	// Keep an entry which knows at least as many solutions
+	if (old != NULL && (old->complete
+	    || (!entry->complete && old->count >= entry->count))) {
+		bnx_cache_unlink(cache, old);
+		bnx_cache_push(cache, old);
+		pthread_mutex_unlock(&cache->lock);
+		bnx_cache_entry_free(entry);
+		return 0;
+	}
+
+	if (old != NULL) {
+		bnx_cache_remove(cache, old);
+	} else if (cache->count == cache->capacity) {
+		bnx_cache_remove(cache, cache->oldest);
+	}
+
+	struct BnxCacheEntry **bucket = bnx_cache_bucket(cache, entry->hash);
+	entry->chain = *bucket;
+	*bucket = entry;
+	bnx_cache_push(cache, entry);
+	cache->count++;
+
+	pthread_mutex_unlock(&cache->lock);
+
+	return 0;
+}
+
+int
+bnx_cache_load(struct BnxCache *cache, const char *filename)
+{
+	struct BnxReader reader;
+	FILE *file = fopen(filename, "r");
+	if (file == NULL) {
+		return errno == ENOENT ? -ENOENT : -EIO;
+	}
+
+	if (bnx_reader_init(&reader, file) != 0) {
+		fclose(file);
+		return -ENOMEM;
+	}
+
+	int error;
+	size_t complete;
+	size_t count;
+	while ((error = bnx_reader_number(&reader, &complete)) == 0) {
+
+		struct BnxSolution *list = NULL;
+		struct BnxSolution **tail = &list;
+		struct Bnx *key = NULL;
+		size_t i;
+
+		if (bnx_reader_number(&reader, &count) != 0
+		    || (key = bnx_reader_next(&reader, NULL)) == NULL) {
+			error = -EINVAL;
+		}
+
+		for (i = 0; i < count && error == 0; i++) {
+			struct Bnx *b = bnx_reader_next(&reader, NULL);
+			*tail = b != NULL ? bnx_solution_alloc() : NULL;
+			if (*tail == NULL) {
+				bnx_free(b);
+				error = -EINVAL;
+			} else {
+				(*tail)->data = b;
+				tail = &(*tail)->next;
+			}
+		}
+
+		if (error == 0) {
+			error = bnx_cache_put(cache, key, complete
+				? BNX_SOLUTION_MODE_ALL : (int)count, list);
+		}
+
+		bnx_solution_free(list);
+		bnx_free(key);
+
+		if (error != 0) {
+			break;
+		}
+	}
+
+	// All entries were read
+	if (error == -ENOENT) {
+		error = 0;
+	} else {
+		fprintf(stderr, "Could not load cache file %s\n", filename);
+	}
+
+	bnx_reader_free(&reader);
+	fclose(file);
+
+	return error;
+}
+
+int
+bnx_cache_save(struct BnxCache *cache, const char *filename)
+{
+	// A crash while writing leaves the old file intact
+	const size_t length = strlen(filename) + sizeof(".XXXXXX");
+	char *temp = malloc(length);
+	if (temp == NULL) {
+		fprintf(stderr, "Could not allocate memory for cache\n");
+		return -ENOMEM;
+	}
+	snprintf(temp, length, "%s.XXXXXX", filename);
+
+	const int fd = mkstemp(temp);
+	FILE *file = fd >= 0 ? fdopen(fd, "w") : NULL;
+	if (file == NULL) {
+		fprintf(stderr, "Could not open file\n");
+		if (fd >= 0) {
+			close(fd);
+			remove(temp);
+		}
+		free(temp);
+		return -EIO;
+	}
+
+	fputs(BNX_CACHE_HEADER, file);
+
+	pthread_mutex_lock(&cache->lock);
+
+	// Loading puts the most recently used entry last again
+	struct BnxCacheEntry *entry;
+	for (entry = cache->oldest; entry != NULL; entry = entry->newer) {
+		fprintf(file, "%d %zu\n", entry->complete, entry->count);
+		bnx_write_stream(file, entry->key);
+
+		size_t i;
+		for (i = 0; i < entry->count; i++) {
+			bnx_write_stream(file, entry->solution[i]);
+		}
+	}
+
+	pthread_mutex_unlock(&cache->lock);
+
+	int error = ferror(file) ? -EIO : 0;
+	if (fclose(file) != 0 || (error == 0 && rename(temp, filename) != 0)) {
+		error = -EIO;
+	}
+	if (error != 0) {
+		fprintf(stderr, "Could not write cache file %s\n", filename);
+		remove(temp);
+	}
+	free(temp);
+
+	return error;
+}
+
+void
+bnx_cache_free(struct BnxCache *cache)
+{
+	while (cache->newest != NULL) {
+		bnx_cache_remove(cache, cache->newest);
+	}
+
+	free(cache->bucket);
+	pthread_mutex_destroy(&cache->lock);
+	memset(cache, 0, sizeof(struct BnxCache));
+}
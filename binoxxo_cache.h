@@ -0,0 +1,139 @@
+// 
+// binoxxo_cache.h
+// Copyright (C) 2014  Florian Tanner <florian.tanner@gmail.com>
+// 
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+// 
+
+
+
+
+#ifndef BINOXXO_CACHE_H
+#define BINOXXO_CACHE_H
+
+#include <pthread.h>
+#include <stdint.h>
+
+#include "binoxxo.h"
+#include "binoxxo_solver.h"
+
+///
+/// Default number of entries of a cache
+///
+#define BNX_CACHE_CAPACITY 4096
+
+///
+/// Solved puzzle in canonical form, see bnx_canonical
+///
+struct BnxCacheEntry {
+	struct Bnx *key;					// Canonical puzzle
+	struct Bnx **solution;				// Solutions of the key
+	size_t count;
+	int complete;						// No other solutions exist
+	uint64_t hash;
+	struct BnxCacheEntry *chain;		// Next entry of the bucket
+	struct BnxCacheEntry *newer;		// Neighbours in order of use
+	struct BnxCacheEntry *older;
+};
+
+///
+/// Solved puzzles keyed by their canonical form, so the rotated, mirrored
+/// and swapped variants of a puzzle share one entry. When full, the least
+/// recently used entry is dropped. A cache is thread-safe.
+///
+struct BnxCache {
+	pthread_mutex_t lock;
+	size_t capacity;
+	size_t count;
+	struct BnxCacheEntry **bucket;		// Hash table of chained entries
+	size_t buckets;						// Power of two
+	struct BnxCacheEntry *newest;
+	struct BnxCacheEntry *oldest;
+	size_t hits;
+	size_t misses;
+};
+
+///
+/// \brief Initialize an empty cache
+///
+/// \param Cache
+/// \param Maximal number of entries
+/// \return Error
+///
+int
+bnx_cache_init(struct BnxCache *, const size_t);
+
+///
+/// \brief Look up the solutions of a puzzle. Solutions of an equivalent
+/// 	puzzle are mapped back through the inverse symmetry.
+///
+/// \param Cache
+/// \param Puzzle
+/// \param Solution mode, see bnx_solve
+/// \param Solutions, only set on a hit
+/// \return True on a hit, false if the puzzle has to be solved
+///
+int
+bnx_cache_get(struct BnxCache *, struct Bnx const * const, const int,
+              struct BnxSolution **);
+
+///
+/// \brief Store the solutions of a puzzle
+///
+/// \param Cache
+/// \param Puzzle
+/// \param Solution mode the solutions were searched with
+/// \param Solutions, copied
+/// \return Error
+///
+int
+bnx_cache_put(struct BnxCache *, struct Bnx const * const, const int,
+              struct BnxSolution const *);
+
+///
+/// \brief Add the entries of a file written by bnx_cache_save
+///
+/// \param Cache
+/// \param Filename
+/// \return Error, -ENOENT if the file does not exist
+///
+int
+bnx_cache_load(struct BnxCache *, const char *);
+
+///
+/// \brief Write all entries to a file, from the least to the most
+/// 	recently used. The file is written under a temporary name and then
+/// 	renamed over the old one.
+///
+/// 	The file is a stream of bnx_reader_next. It starts with a comment
+/// 	line, then every entry is a line with the completeness flag and the
+/// 	number of solutions, followed by the canonical puzzle and its
+/// 	solutions.
+///
+/// \param Cache
+/// \param Filename
+/// \return Error
+///
+int
+bnx_cache_save(struct BnxCache *, const char *);
+
+///
+/// \brief Release all entries
+///
+/// \param Cache
+///
+void
+bnx_cache_free(struct BnxCache *);
+
+#endif // BINOXXO_CACHE_H
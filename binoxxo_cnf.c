@@ -0,0 +1,219 @@
+// 
+// binoxxo_cnf.c
+// Copyright (C) 2014  Florian Tanner <florian.tanner@gmail.com>
+// 
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+// 
+
+
+
+
+#include <errno.h>
+#include <stdlib.h>
+
+#include "binoxxo_cnf.h"
+
+void
+bnx_cnf_init(struct BnxCnf *cnf, const size_t size)
+{
+	cnf->size     = size;
+	cnf->vars     = size * size;
+	cnf->clauses  = 0;
+	cnf->lit      = NULL;
+	cnf->length   = 0;
+	cnf->capacity = 0;
+	cnf->error    = 0;
+}
+
+int
+bnx_cnf_var(struct BnxCnf *cnf)
+{
+	return ++cnf->vars;
+}
+
+void
+bnx_cnf_add(struct BnxCnf *cnf, const int lit)
+{
+	if (cnf->error) {
+		return;
+	}
+
+	if (cnf->length == cnf->capacity) {
+		const size_t capacity = cnf->capacity ? 2 * cnf->capacity : 4096;
+		int *grown = realloc(cnf->lit, capacity * sizeof(int));
+		if (grown == NULL) {
+			fprintf(stderr, "Could not allocate memory for clauses\n");
+			cnf->error = -ENOMEM;
+			return;
+		}
+		cnf->lit      = grown;
+		cnf->capacity = capacity;
+	}
+
+	cnf->lit[cnf->length++] = lit;
+	if (lit == 0) {
+		cnf->clauses++;
+	}
+}
+
+static void
+bnx_cnf_clause(struct BnxCnf *cnf, const int a, const int b, const int c)
+{
+	bnx_cnf_add(cnf, a);
+	if (b != 0) {
+		bnx_cnf_add(cnf, b);
+	}
+	if (c != 0) {
+		bnx_cnf_add(cnf, c);
+	}
+	bnx_cnf_add(cnf, 0);
+}
+
+///
+/// \brief Sequential counter, at most k of the literals are true
+///
+/// 	Auxiliary variable s(i, j) is true if at least j + 1 of the first
+/// 	i + 1 literals are true.
+///
+/// \param Formula
+/// \param Literals
+/// \param Number of literals
+/// \param Maximal number of true literals, at least 1
+///
+static void
+bnx_cnf_at_most(struct BnxCnf *cnf, int const * const lit, const int n,
+                const int k)
+{
+	int prev[BNX_MAX_SIZE];
+	int cur[BNX_MAX_SIZE];
+	int i;
+	int j;
+
+	for (j = 0; j < k; j++) {
+		prev[j] = bnx_cnf_var(cnf);
+		if (j > 0) {
+			bnx_cnf_clause(cnf, -prev[j], 0, 0);
+		}
+	}
+	bnx_cnf_clause(cnf, -lit[0], prev[0], 0);
+
+	for (i = 1; i < n - 1; i++) {
+		for (j = 0; j < k; j++) {
+			cur[j] = bnx_cnf_var(cnf);
+		}
+
+		bnx_cnf_clause(cnf, -lit[i], cur[0], 0);
+		bnx_cnf_clause(cnf, -prev[0], cur[0], 0);
+		for (j = 1; j < k; j++) {
+			bnx_cnf_clause(cnf, -lit[i], -prev[j - 1], cur[j]);
+			bnx_cnf_clause(cnf, -prev[j], cur[j], 0);
+		}
+		bnx_cnf_clause(cnf, -lit[i], -prev[k - 1], 0);
+
+		for (j = 0; j < k; j++) {
+			prev[j] = cur[j];
+		}
+	}
+
+	bnx_cnf_clause(cnf, -lit[n - 1], -prev[k - 1], 0);
+}
+
+static void
+bnx_cnf_line(struct BnxCnf *cnf, const int dir, const int index, int *lit)
+{
+	const size_t size = cnf->size;
+	int i;
+
+	for (i = 0; i < size; i++) {
+		lit[i] = dir == BNX_DIR_H ? bnx_cnf_field(size, index, i)
+			: bnx_cnf_field(size, i, index);
+	}
+}
+
+int
+bnx_cnf_encode(struct BnxCnf *cnf, struct BnxBoard const * const board)
+{
+	const size_t size = board->size;
+	int line[BNX_MAX_SIZE];
+	int other[BNX_MAX_SIZE];
+	int row;
+	int col;
+	int dir;
+	int i;
+	int j;
+
+	if (size != cnf->size || size < 2) {
+		return -EINVAL;
+	}
+
+	for (row = 0; row < size; row++) {
+		for (col = 0; col < size; col++) {
+			const int field = bnx_board_get(board, row, col);
+			const int var = bnx_cnf_field(size, row, col);
+			if (field == BNX_FIELD_X) {
+				bnx_cnf_clause(cnf, var, 0, 0);
+			} else if (field == BNX_FIELD_O) {
+				bnx_cnf_clause(cnf, -var, 0, 0);
+			}
+		}
+	}
+
+	for (dir = BNX_DIR_H; dir <= BNX_DIR_V; dir++) {
+		for (i = 0; i < size; i++) {
+			bnx_cnf_line(cnf, dir, i, line);
+
+			for (j = 0; j + 2 < size; j++) {
+				bnx_cnf_clause(cnf, line[j], line[j + 1], line[j + 2]);
+				bnx_cnf_clause(cnf, -line[j], -line[j + 1], -line[j + 2]);
+			}
+
+			bnx_cnf_at_most(cnf, line, size, size / 2);
+			for (j = 0; j < size; j++) {
+				other[j] = -line[j];
+			}
+			bnx_cnf_at_most(cnf, other, size, size / 2);
+		}
+
+		for (i = 0; i < size; i++) {
+			bnx_cnf_line(cnf, dir, i, line);
+
+			for (j = i + 1; j < size; j++) {
+				int p;
+				int differ[BNX_MAX_SIZE];
+
+				bnx_cnf_line(cnf, dir, j, other);
+				for (p = 0; p < size; p++) {
+					differ[p] = bnx_cnf_var(cnf);
+					bnx_cnf_clause(cnf, -differ[p], line[p], other[p]);
+					bnx_cnf_clause(cnf, -differ[p], -line[p], -other[p]);
+				}
+				for (p = 0; p < size; p++) {
+					bnx_cnf_add(cnf, differ[p]);
+				}
+				bnx_cnf_add(cnf, 0);
+			}
+		}
+	}
+
+	return cnf->error;
+}
+
+void
+bnx_cnf_free(struct BnxCnf *cnf)
+{
+	free(cnf->lit);
+	cnf->lit      = NULL;
+	cnf->length   = 0;
+	cnf->capacity = 0;
+}
@@ -0,0 +1,113 @@
+// 
+// binoxxo_cnf.h
+// Copyright (C) 2014  Florian Tanner <florian.tanner@gmail.com>
+// 
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+// 
+
+
+
+
+#ifndef BINOXXO_CNF_H
+#define BINOXXO_CNF_H
+
+#include <stddef.h>
+
+#include "binoxxo_board.h"
+
+///
+/// Formula in conjunctive normal form
+/// Literals are stored like in DIMACS, variable v as v or -v, and every
+/// clause is ended by a 0. Variable bnx_cnf_field(size, row, col) is true if
+/// the field holds an x, all following variables are auxiliary.
+///
+struct BnxCnf {
+	size_t size;					// Size of the encoded binoxxo
+	int vars;						// Number of variables
+	int clauses;					// Number of clauses
+	int *lit;						// Literals of all clauses
+	size_t length;					// Used literals
+	size_t capacity;
+	int error;						// First error while building
+};
+
+///
+/// \brief Variable of a field
+///
+/// \param Size of the binoxxo
+/// \param Row
+/// \param Column
+/// \return Variable
+///
+static inline int
+bnx_cnf_field(const size_t size, const int row, const int col)
+{
+	return row * size + col + 1;
+}
+
+///
+/// \brief Initialize a formula with the field variables of a binoxxo and
+/// 	no clauses
+///
+/// \param Formula
+/// \param Size of the binoxxo
+///
+void
+bnx_cnf_init(struct BnxCnf *, const size_t);
+
+///
+/// \brief Add an auxiliary variable
+///
+/// \param Formula
+/// \return Variable
+///
+int
+bnx_cnf_var(struct BnxCnf *);
+
+///
+/// \brief Append a literal to the current clause, 0 ends the clause. Running
+/// 	out of memory is remembered in the formula and ends building.
+///
+/// \param Formula
+/// \param Literal
+///
+void
+bnx_cnf_add(struct BnxCnf *, const int);
+
+///
+/// \brief Encode the rules of a binoxxo and its given fields
+///
+/// 	Givens are unit clauses. Every three neighbouring fields of a line
+/// 	hold at least one o and one x. The balance of every line is the
+/// 	pair "at most size / 2 x's" and "at most size / 2 o's", each a
+/// 	sequential counter with (size - 1) * size / 2 auxiliary variables.
+/// 	Two lines of a direction differ in at least one position, a
+/// 	position differs if its auxiliary variable is true.
+///
+/// \param Formula, initialized for the size of the board
+/// \param Board
+/// \return Error
+///
+int
+bnx_cnf_encode(struct BnxCnf *, struct BnxBoard const * const);
+
+///
+/// \brief Release the clauses of a formula
+///
+/// \param Formula
+///
+void
+bnx_cnf_free(struct BnxCnf *);
+
+#endif // BINOXXO_CNF_H
@@ -0,0 +1,417 @@
+// 
+// binoxxo_generator.c
+// Copyright (C) 2014  Florian Tanner <florian.tanner@gmail.com>
+// 
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+// 
+
+
+
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <unistd.h>
+
+#include "binoxxo_generator.h"
+#include "binoxxo_io.h"
+
+///
+/// Puzzles per thread which may wait in the reorder buffer of bnx_generate
+///
+#define BNX_GENERATE_WINDOW 4
+
+///
+/// Shared state of the threads of bnx_generate
+///
+struct BnxGenerateShared {
+	FILE *file;
+	struct BnxWriter writer;		// Used for the binary format
+	int binary;
+	size_t size;
+	size_t count;
+	uint64_t seed;
+	atomic_size_t next;				// Next puzzle to generate
+	pthread_mutex_t lock;			// Guards the output
+	pthread_cond_t space;			// Signaled when puzzles were written
+	struct Bnx **slot;				// Reorder buffer, puzzle i waits in
+	int *result;					// slot i % window until all puzzles
+	int *ready;						// before it are written
+	size_t window;
+	size_t written;					// Puzzles written in index order
+	int error;
+};
+
+int
+bnx_generator_init(struct BnxGeneratorWorker *w, const size_t size)
+{
+	memset(w, 0, sizeof(struct BnxGeneratorWorker));
+
+	if (size < bnx_min_size || size > BNX_MAX_SIZE || size % 2 != 0) {
+		fprintf(stderr, "Size must be between %zu and %d and a multiple "
+			"of 2\n", bnx_min_size, BNX_MAX_SIZE);
+		return -EINVAL;
+	}
+
+	bnx_lines_init();
+
+	w->empty    = bnx_alloc(size);
+	w->solution = bnx_alloc(size);
+	w->order    = malloc(size * size * sizeof(int));
+	w->mark     = malloc(size * size * sizeof(size_t));
+	w->kept     = malloc(size * size * sizeof(int));
+	if (w->empty != NULL) {
+		w->grid  = bnx_ctx_alloc(w->empty, BNX_GUESS_RANDOM, NULL);
+		w->check = bnx_ctx_alloc(w->empty, BNX_GUESS_MOSTFILLED, NULL);
+	}
+
+	if (!w->empty || !w->solution || !w->order || !w->mark || !w->kept
+	    || !w->grid || !w->check) {
+		fprintf(stderr, "Could not allocate memory for generator\n");
+		bnx_generator_free(w);
+		return -ENOMEM;
+	}
+
+	return 0;
+}
+
+///
+/// \brief Set a field of the solution on the board of the check context
+///
+static void
+bnx_generator_set(struct BnxGeneratorWorker *w, const int field,
+                  const int invert)
+{
+	const size_t size = w->solution->size;
+	const int value = w->solution->data[0][field];
+
+	bnx_board_set(w->check->board, field / size, field % size,
+	              invert ? value * BNX_INVERT_FIELD : value);
+}
+
+///
+/// \brief Check whether the board of the check context has a solution with
+/// 	the value of a field inverted
+///
+/// \param Worker
+/// \param Field index
+/// \return True if such a solution exists
+///
+static int
+bnx_generator_other(struct BnxGeneratorWorker *w, const int field)
+{
+	struct BnxCollector collector;
+	const size_t size = w->solution->size;
+
+	// Propagation of the other givens already forced the value
+	if (bnx_board_get(w->check->board, field / size, field % size)
+	    != BNX_FIELD_EMPTY) {
+		return false;
+	}
+
+	bnx_generator_set(w, field, true);
+
+	bnx_collector_init_count(&collector, BNX_SOLUTION_MODE_ONE, NULL);
+	w->check->collector = &collector;
+	bnx_solve_ctx(w->check);
+	bnx_collector_destroy(&collector);
+
+	return collector.count > 0;
+}
+
+int
+bnx_generator_run(struct BnxGeneratorWorker *w, struct Bnx *puzzle,
+                  const uint64_t seed)
+{
+	const size_t size = w->empty->size;
+	const int fields = size * size;
+	struct BnxCollector collector;
+	int i;
+
+	if (puzzle->size != size) {
+		return -EINVAL;
+	}
+
+	// A random full grid
+	bnx_ctx_load(w->grid, w->empty);
+	bnx_ctx_seed(w->grid, seed);
+	bnx_collector_init_count(&collector, BNX_SOLUTION_MODE_ONE, w->solution);
+	w->grid->collector = &collector;
+	bnx_solve_ctx(w->grid);
+	bnx_collector_destroy(&collector);
+
+	if (collector.count == 0) {
+		return -EINVAL;
+	}
+
+	// Fields in random order, shuffled with the generator of the grid
+	for (i = 0; i < fields; i++) {
+		w->order[i] = i;
+	}
+	for (i = fields - 1; i > 0; i--) {
+		const int j = bnx_random_below(&w->grid->random, i + 1);
+		const int swap = w->order[i];
+		w->order[i] = w->order[j];
+		w->order[j] = swap;
+	}
+
+	bnx_copy(puzzle, w->solution);
+
+	// The first given to remove ends up on top of the trail
+	struct BnxBoard *board = w->check->board;
+	bnx_board_init(board, size);
+	for (i = fields - 1; i >= 0; i--) {
+		w->mark[i] = bnx_board_mark(board);
+		bnx_generator_set(w, w->order[i], false);
+		bnx_solve_propagate(w->check);
+	}
+
+	int kept = 0;
+	int j;
+	for (i = 0; i < fields; i++) {
+		const int field = w->order[i];
+
+		bnx_board_undo(board, w->mark[i]);
+		for (j = 0; j < kept; j++) {
+			bnx_generator_set(w, w->kept[j], false);
+		}
+		bnx_solve_propagate(w->check);
+
+		if (bnx_generator_other(w, field)) {
+			w->kept[kept++] = field;
+		} else {
+			puzzle->data[0][field] = BNX_FIELD_EMPTY;
+		}
+	}
+
+	return 0;
+}
+
+void
+bnx_generator_free(struct BnxGeneratorWorker *w)
+{
+	if (w->grid != NULL) {
+		bnx_ctx_free(w->grid);
+	}
+	if (w->check != NULL) {
+		bnx_ctx_free(w->check);
+	}
+	bnx_free(w->empty);
+	bnx_free(w->solution);
+	free(w->order);
+	free(w->mark);
+	free(w->kept);
+	memset(w, 0, sizeof(struct BnxGeneratorWorker));
+}
+
+///
+/// \brief Write the finished puzzles at the start of the reorder buffer
+///
+/// \param Shared state, locked
+///
+static void
+bnx_generate_flush(struct BnxGenerateShared *shared)
+{
+	size_t slot;
+
+	while (shared->ready[slot = shared->written % shared->window]) {
+		int error = shared->result[slot];
+
+		if (error == 0 && shared->error == 0) {
+			if (shared->binary) {
+				error = bnx_writer_add(&shared->writer, shared->slot[slot]);
+			} else {
+				bnx_write_stream(shared->file, shared->slot[slot]);
+			}
+		}
+		if (error != 0 && shared->error == 0) {
+			shared->error = error;
+		}
+
+		shared->ready[slot] = false;
+		shared->written++;
+	}
+
+	pthread_cond_broadcast(&shared->space);
+}
+
+static void *
+bnx_generate_thread(void *arg)
+{
+	struct BnxGenerateShared *shared = arg;
+	struct BnxGeneratorWorker worker;
+	int stop = false;
+	size_t i;
+
+	int error = bnx_generator_init(&worker, shared->size);
+	struct Bnx *puzzle = error == 0 ? bnx_alloc(shared->size) : NULL;
+	if (error == 0 && puzzle == NULL) {
+		error = -ENOMEM;
+		bnx_generator_free(&worker);
+	}
+	if (error != 0) {
+		pthread_mutex_lock(&shared->lock);
+		shared->error = shared->error ? shared->error : error;
+		pthread_mutex_unlock(&shared->lock);
+		return NULL;
+	}
+
+	while (!stop
+	       && (i = atomic_fetch_add(&shared->next, 1)) < shared->count) {
+
+		error = bnx_generator_run(&worker, puzzle, shared->seed + i);
+
+		pthread_mutex_lock(&shared->lock);
+
+		// Puzzles are written in index order, a thread far ahead waits
+		while (i >= shared->written + shared->window) {
+			pthread_cond_wait(&shared->space, &shared->lock);
+		}
+
+		const size_t slot = i % shared->window;
+		struct Bnx *swap = shared->slot[slot];
+		shared->slot[slot]   = puzzle;
+		shared->result[slot] = error;
+		shared->ready[slot]  = true;
+		puzzle = swap;
+
+		bnx_generate_flush(shared);
+		stop = shared->error != 0;
+
+		pthread_mutex_unlock(&shared->lock);
+	}
+
+	bnx_free(puzzle);
+	bnx_generator_free(&worker);
+
+	return NULL;
+}
+
+///
+/// \brief Allocate the reorder buffer
+///
+/// \param Shared state
+/// \return Error
+///
+static int
+bnx_generate_alloc(struct BnxGenerateShared *shared)
+{
+	size_t i;
+
+	shared->slot   = calloc(shared->window, sizeof(struct Bnx *));
+	shared->result = calloc(shared->window, sizeof(int));
+	shared->ready  = calloc(shared->window, sizeof(int));
+	if (shared->slot == NULL || shared->result == NULL
+	    || shared->ready == NULL) {
+		fprintf(stderr, "Could not allocate memory for generator\n");
+		return -ENOMEM;
+	}
+
+	for (i = 0; i < shared->window; i++) {
+		shared->slot[i] = bnx_alloc(shared->size);
+		if (shared->slot[i] == NULL) {
+			return -ENOMEM;
+		}
+	}
+
+	return 0;
+}
+
+static void
+bnx_generate_free(struct BnxGenerateShared *shared)
+{
+	size_t i;
+
+	for (i = 0; shared->slot != NULL && i < shared->window; i++) {
+		bnx_free(shared->slot[i]);
+	}
+	free(shared->slot);
+	free(shared->result);
+	free(shared->ready);
+	pthread_cond_destroy(&shared->space);
+	pthread_mutex_destroy(&shared->lock);
+}
+
+int
+bnx_generate(FILE *file, const size_t size, const size_t count, int threads,
+             const uint64_t seed, const int binary)
+{
+	struct BnxGenerateShared shared;
+
+	if (size < bnx_min_size || size > BNX_MAX_SIZE || size % 2 != 0) {
+		fprintf(stderr, "Size must be between %zu and %d and a multiple "
+			"of 2\n", bnx_min_size, BNX_MAX_SIZE);
+		return -EINVAL;
+	}
+
+	if (threads <= 0) {
+		threads = sysconf(_SC_NPROCESSORS_ONLN);
+		if (threads <= 0) {
+			threads = 1;
+		}
+	}
+
+	// Before the threads, which only read the tables
+	bnx_lines_init();
+
+	memset(&shared, 0, sizeof(struct BnxGenerateShared));
+	shared.file   = file;
+	shared.binary = binary;
+	shared.size   = size;
+	shared.count  = count;
+	shared.seed   = seed;
+	shared.window = BNX_GENERATE_WINDOW * threads;
+	atomic_init(&shared.next, 0);
+	pthread_mutex_init(&shared.lock, NULL);
+	pthread_cond_init(&shared.space, NULL);
+
+	int error = bnx_generate_alloc(&shared);
+	if (error == 0 && binary && bnx_writer_init(&shared.writer, file) != 0) {
+		error = -EIO;
+	}
+	if (error != 0) {
+		bnx_generate_free(&shared);
+		return error;
+	}
+
+	pthread_t *thread = calloc(threads, sizeof(pthread_t));
+	int started = 0;
+	int i;
+	for (i = 1; i < threads && thread != NULL; i++) {
+		if (pthread_create(&thread[i], NULL, &bnx_generate_thread,
+		                   &shared) != 0) {
+			break;
+		}
+		started++;
+	}
+
+	// The calling thread works as well
+	bnx_generate_thread(&shared);
+
+	for (i = 1; i <= started; i++) {
+		pthread_join(thread[i], NULL);
+	}
+	free(thread);
+
+	if (binary) {
+		const int finish = bnx_writer_finish(&shared.writer);
+		shared.error = shared.error ? shared.error : finish;
+	}
+
+	error = shared.error;
+	bnx_generate_free(&shared);
+
+	return error;
+}
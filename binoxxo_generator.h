@@ -0,0 +1,102 @@
+// 
+// binoxxo_generator.h
+// Copyright (C) 2014  Florian Tanner <florian.tanner@gmail.com>
+// 
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+// 
+
+
+
+
+#ifndef BINOXXO_GENERATOR_H
+#define BINOXXO_GENERATOR_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include "binoxxo.h"
+#include "binoxxo_solver.h"
+
+///
+/// State of one generating thread
+///
+struct BnxGeneratorWorker {
+	struct BnxSolverCtx *grid;		// Random search for full grids
+	struct BnxSolverCtx *check;		// Search for other solutions
+	struct Bnx *empty;
+	struct Bnx *solution;
+	int *order;						// Fields in order of removal
+	size_t *mark;					// Trail mark before every given
+	int *kept;						// Givens which can not be removed
+};
+
+///
+/// \brief Prepare a generating thread for one size
+///
+/// \param Worker
+/// \param Size
+/// \return Error, -EINVAL for an invalid size
+///
+int
+bnx_generator_init(struct BnxGeneratorWorker *, const size_t);
+
+///
+/// \brief Generate a puzzle with exactly one solution
+///
+/// 	A random full grid is searched with the random guesser. Then the
+/// 	givens are removed one by one in random order. A removal is kept if
+/// 	no solution has the opposite value in the removed field, which is
+/// 	the check "at most one solution" with the first solution known.
+/// 	Every remaining given is needed for uniqueness.
+///
+/// 	The givens are set in reverse order of removal, each followed by
+/// 	propagation, and the trail is marked before each. A removal undoes
+/// 	the board to the mark of its given, which restores the propagated
+/// 	board of all later givens, and only the kept givens are set and
+/// 	propagated again.
+///
+/// \param Worker
+/// \param Puzzle of the size of the worker
+/// \param Seed, the same seed gives the same puzzle
+/// \return Error
+///
+int
+bnx_generator_run(struct BnxGeneratorWorker *, struct Bnx *, const uint64_t);
+
+///
+/// \brief Release a generating thread
+///
+/// \param Worker
+///
+void
+bnx_generator_free(struct BnxGeneratorWorker *);
+
+///
+/// \brief Generate puzzles with several threads and write them in the
+/// 	order of their seeds, in the text format of bnx_read_file or the
+/// 	binary format. The output does not depend on the number of threads.
+///
+/// \param Stream
+/// \param Size
+/// \param Number of puzzles
+/// \param Number of threads, 0 for one per processor
+/// \param Seed, puzzle i is generated with seed + i
+/// \param True for the binary format
+/// \return Error
+///
+int
+bnx_generate(FILE *, const size_t, const size_t, int, const uint64_t,
+             const int);
+
+#endif // BINOXXO_GENERATOR_H
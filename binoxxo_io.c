@@ -17,10 +17,42 @@
 // 
 
 
+#define _POSIX_C_SOURCE 200809L
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "binoxxo_cnf.h"
 #include "binoxxo_io.h"
 
 const size_t bnx_buffer_size = 24;
 
+const size_t bnx_reader_buffer_size = 1 << 16;
+
+const char bnx_binary_magic[4] = {'B', 'N', 'X', 'B'};
+
+///
+/// Layout of the binary header, all fields are little endian
+///
+enum BnxBinaryHeader {
+	BNX_BINARY_VERSION_AT = 4,		// 16 bit format version
+	BNX_BINARY_SIZE_AT    = 6,		// 16 bit size of all binoxxos
+	BNX_BINARY_COUNT_AT   = 8,		// 64 bit number of binoxxos
+	BNX_BINARY_TABLE_AT   = 16,		// 64 bit position of the offset table
+	BNX_BINARY_HEADER     = 24,
+};
+
+///
+/// Cell codes of the binary format
+///
+enum BnxBinaryCell {
+	BNX_CELL_EMPTY = 0,
+	BNX_CELL_O     = 1,
+	BNX_CELL_X     = 2,
+};
+
 static char
 bnx_field_to_char(const int field)
 {
@@ -69,11 +101,29 @@ bnx_line_print(struct BnxLine const * const l)
 	const size_t size = l->size;
 	int i;
 	for (i = 0; i < size; i++) {
-		printf("%c", bnx_field_to_char(*l->data[i]));
+		printf("%c", bnx_field_to_char(*bnx_line_field(l, i)));
 	}
 	printf("\n");
 }
 
+void
+bnx_stats_print(FILE *file, struct BnxStats const * const stats)
+{
+	fprintf(file, "{\"nodes\": %lu, \"backtracks\": %lu, "
+	        "\"max_depth\": %lu, \"forced\": {\"double\": %lu, "
+	        "\"triple\": %lu, \"count\": %lu, \"lines\": %lu}, "
+	        "\"validations\": %lu, \"restarts\": %lu, "
+	        "\"peak_boards\": %lu, "
+	        "\"seconds\": {\"propagation\": %.6f, \"validation\": %.6f, "
+	        "\"guessing\": %.6f}}\n",
+	        stats->nodes, stats->backtracks, stats->max_depth,
+	        stats->forced[BNX_RULE_DOUBLE], stats->forced[BNX_RULE_TRIPLE],
+	        stats->forced[BNX_RULE_COUNT], stats->forced[BNX_RULE_LINES],
+	        stats->validations, stats->restarts, stats->boards,
+	        stats->propagation,
+	        stats->validation, stats->guessing);
+}
+
 static void
 bnx_get_input(char *buffer, const size_t size)
 {
@@ -179,6 +229,486 @@ bnx_fill_by_input(void)
 	return b;
 }
 
+int
+bnx_reader_init(struct BnxReader *r, FILE *file)
+{
+	r->buffer = malloc(sizeof(char) * bnx_reader_buffer_size);
+	if (r->buffer == NULL) {
+		fprintf(stderr, "Could not allocate buffer for reader\n");
+		return -ENOMEM;
+	}
+
+	r->file   = file;
+	r->length = 0;
+	r->pos    = 0;
+	r->line   = 1;
+	r->error  = 0;
+
+	return 0;
+}
+
+void
+bnx_reader_free(struct BnxReader *r)
+{
+	free(r->buffer);
+	r->buffer = NULL;
+}
+
+static void
+bnx_map_reader(struct BnxMap const * const map, struct BnxReader *r,
+               const size_t offset, const size_t line)
+{
+	// The reader never writes to its buffer
+	r->file   = NULL;
+	r->buffer = (char *)map->data + offset;
+	r->length = map->length - offset;
+	r->pos    = 0;
+	r->line   = line;
+	r->error  = 0;
+}
+
+static int
+bnx_reader_peek(struct BnxReader *r)
+{
+	if (r->pos == r->length) {
+		// Readers on mapped memory have nothing to refill
+		if (r->file == NULL) {
+			return EOF;
+		}
+		r->length = fread(r->buffer, sizeof(char), bnx_reader_buffer_size,
+		                  r->file);
+		r->pos = 0;
+		if (r->length == 0) {
+			return EOF;
+		}
+	}
+
+	return (unsigned char)r->buffer[r->pos];
+}
+
+static int
+bnx_reader_getc(struct BnxReader *r)
+{
+	const int c = bnx_reader_peek(r);
+
+	if (c != EOF) {
+		r->pos++;
+		if (c == '\n') {
+			r->line++;
+		}
+	}
+
+	return c;
+}
+
+static void
+bnx_reader_skip(struct BnxReader *r)
+{
+	int c;
+
+	while ((c = bnx_reader_peek(r)) != EOF) {
+		if (c == '#') {
+			// Comment up to the end of the line
+			while (c != EOF && c != '\n') {
+				c = bnx_reader_getc(r);
+			}
+		} else if (isspace(c)) {
+			bnx_reader_getc(r);
+		} else {
+			break;
+		}
+	}
+}
+
+static int
+bnx_reader_row(struct BnxReader *r, int *data, const size_t size,
+               const int row)
+{
+	int col;
+
+	bnx_reader_skip(r);
+
+	for (col = 0; col < size; col++) {
+		// A digit starts the next binoxxo and is left to it
+		const int c = bnx_reader_peek(r);
+		if (c == EOF || isspace(c) || isdigit(c)) {
+			fprintf(stderr, "Row %i is too short, line %zu\n", row + 1,
+			        r->line);
+			return -EINVAL;
+		}
+		bnx_reader_getc(r);
+		// Rows are only skipped without data
+		if (data != NULL) {
+			data[col] = bnx_char_to_field(c);
+		}
+	}
+
+	const int c = bnx_reader_peek(r);
+	if (c != EOF && !isspace(c)) {
+		fprintf(stderr, "Row %i is too long, line %zu\n", row + 1, r->line);
+		return -EINVAL;
+	}
+
+	return 0;
+}
+
+static size_t
+bnx_reader_size(struct BnxReader *r)
+{
+	size_t size = 0;
+	int digits = 0;
+	int c;
+
+	bnx_reader_skip(r);
+
+	while ((c = bnx_reader_peek(r)) != EOF && isdigit(c)) {
+		size = 10 * size + (c - '0');
+		bnx_reader_getc(r);
+		digits++;
+	}
+
+	if (digits == 0 && c != EOF) {
+		fprintf(stderr, "Size expected, line %zu\n", r->line);
+	}
+
+	return digits > 0 ? size : 0;
+}
+
+///
+/// \brief Skip the rest of a binoxxo with a syntax error, up to the next
+/// 	line starting with a digit
+///
+/// \param Reader
+///
+static void
+bnx_reader_resync(struct BnxReader *r)
+{
+	int c;
+
+	bnx_reader_skip(r);
+
+	while ((c = bnx_reader_peek(r)) != EOF && !isdigit(c)) {
+		while (c != EOF && c != '\n') {
+			c = bnx_reader_getc(r);
+		}
+		bnx_reader_skip(r);
+	}
+}
+
+struct Bnx *
+bnx_reader_next(struct BnxReader *r, struct Bnx *b)
+{
+	r->error = 0;
+
+	bnx_reader_skip(r);
+	if (bnx_reader_peek(r) == EOF) {
+		bnx_free(b);
+		return NULL;
+	}
+
+	const size_t size = bnx_reader_size(r);
+	int error = size > 0 ? 0 : -EINVAL;
+
+	if (error == 0 && (b == NULL || b->size != size)) {
+		bnx_free(b);
+		b = bnx_alloc(size);
+		if (b == NULL) {
+			// bnx_alloc reports invalid sizes
+			const int valid = size % 2 == 0 && size >= bnx_min_size
+				&& size <= BNX_MAX_SIZE;
+			error = valid ? -ENOMEM : -EINVAL;
+		}
+	}
+
+	int i;
+	for (i = 0; i < size && error == 0; i++) {
+		error = bnx_reader_row(r, b->data[i], size, i);
+	}
+
+	if (error != 0) {
+		r->error = error;
+		bnx_free(b);
+		bnx_reader_resync(r);
+		return NULL;
+	}
+
+	return b;
+}
+
+int
+bnx_reader_number(struct BnxReader *r, size_t *number)
+{
+	int c;
+
+	bnx_reader_skip(r);
+
+	c = bnx_reader_peek(r);
+	if (c == EOF) {
+		return -ENOENT;
+	}
+	if (!isdigit(c)) {
+		fprintf(stderr, "Number expected, line %zu\n", r->line);
+		return -EINVAL;
+	}
+
+	*number = 0;
+	while ((c = bnx_reader_peek(r)) != EOF && isdigit(c)) {
+		*number = 10 * *number + (c - '0');
+		bnx_reader_getc(r);
+	}
+
+	return 0;
+}
+
+static int
+bnx_map_index(struct BnxMap *map)
+{
+	struct BnxReader r;
+	size_t capacity = 0;
+
+	bnx_map_reader(map, &r, 0, 1);
+
+	while (true) {
+		bnx_reader_skip(&r);
+		if (bnx_reader_peek(&r) == EOF) {
+			return 0;
+		}
+
+		const size_t offset = r.pos;
+		const size_t line = r.line;
+		const size_t size = bnx_reader_size(&r);
+		int error = size > 0 ? 0 : -EINVAL;
+
+		// Like a stream the index goes on after a syntax error
+		int i;
+		for (i = 0; i < size && error == 0; i++) {
+			error = bnx_reader_row(&r, NULL, size, i);
+		}
+		if (error != 0) {
+			bnx_reader_resync(&r);
+		}
+
+		if (map->count == capacity) {
+			capacity = capacity ? 2 * capacity : 1024;
+			struct BnxMapEntry *entry = realloc(map->entry,
+				capacity * sizeof(struct BnxMapEntry));
+			if (entry == NULL) {
+				fprintf(stderr, "Could not allocate index\n");
+				return -ENOMEM;
+			}
+			map->entry = entry;
+		}
+
+		map->entry[map->count].offset = offset;
+		map->entry[map->count].line   = line;
+		map->entry[map->count].error  = error;
+		map->count++;
+	}
+}
+
+static void
+bnx_binary_unpack(struct Bnx const *b, const unsigned char *record)
+{
+	static const int field[4] = {
+		[BNX_CELL_EMPTY] = BNX_FIELD_EMPTY,
+		[BNX_CELL_O]     = BNX_FIELD_O,
+		[BNX_CELL_X]     = BNX_FIELD_X,
+		[3]              = BNX_FIELD_EMPTY,
+	};
+
+	// Cells are stored row by row in one block
+	int *data = b->data[0];
+	const size_t cells = b->size * b->size;
+	size_t i;
+
+	for (i = 0; i < cells; i++) {
+		data[i] = field[record[i / 4] >> (2 * (i % 4)) & 3];
+	}
+}
+
+static void
+bnx_binary_pack(unsigned char *record, struct Bnx const * const b)
+{
+	const int *data = b->data[0];
+	const size_t cells = b->size * b->size;
+	size_t i;
+
+	memset(record, 0, bnx_binary_record_size(b->size));
+
+	for (i = 0; i < cells; i++) {
+		int cell = BNX_CELL_EMPTY;
+		if (data[i] == BNX_FIELD_O) {
+			cell = BNX_CELL_O;
+		} else if (data[i] == BNX_FIELD_X) {
+			cell = BNX_CELL_X;
+		}
+		record[i / 4] |= cell << (2 * (i % 4));
+	}
+}
+
+static uint64_t
+bnx_binary_load(const unsigned char *p, const int bytes)
+{
+	uint64_t value = 0;
+	int i;
+
+	for (i = bytes - 1; i >= 0; i--) {
+		value = value << 8 | p[i];
+	}
+
+	return value;
+}
+
+static void
+bnx_binary_store(unsigned char *p, uint64_t value, const int bytes)
+{
+	int i;
+
+	for (i = 0; i < bytes; i++) {
+		p[i] = value & 0xff;
+		value >>= 8;
+	}
+}
+
+static int
+bnx_map_index_binary(struct BnxMap *map)
+{
+	const unsigned char *header = (const unsigned char *)map->data;
+
+	if (bnx_binary_load(header + BNX_BINARY_VERSION_AT, 2)
+	    != BNX_BINARY_VERSION) {
+		fprintf(stderr, "Unknown binary format version\n");
+		return -EINVAL;
+	}
+
+	const size_t size  = bnx_binary_load(header + BNX_BINARY_SIZE_AT, 2);
+	const size_t count = bnx_binary_load(header + BNX_BINARY_COUNT_AT, 8);
+	const size_t table = bnx_binary_load(header + BNX_BINARY_TABLE_AT, 8);
+
+	if (table > map->length || count > (map->length - table) / 8) {
+		fprintf(stderr, "Offset table out of bounds\n");
+		return -EINVAL;
+	}
+
+	// A file without binoxxos was written before any size was known
+	if (count > 0 && (size % 2 != 0 || size < bnx_min_size
+	                  || size > BNX_MAX_SIZE)) {
+		fprintf(stderr, "Invalid binoxxo size %zu in binary header\n", size);
+		return -EINVAL;
+	}
+
+	map->binary = true;
+	map->size   = size;
+	map->count  = count;
+	map->table  = table;
+
+	return 0;
+}
+
+int
+bnx_map_open(struct BnxMap *map, const char *filename)
+{
+	struct stat info;
+
+	memset(map, 0, sizeof(struct BnxMap));
+
+	const int fd = open(filename, O_RDONLY);
+	if (fd < 0) {
+		fprintf(stderr, "Could not open file %s\n", filename);
+		return -ENOENT;
+	}
+
+	// Only regular files can be mapped, empty ones hold no binoxxos
+	if (fstat(fd, &info) != 0 || !S_ISREG(info.st_mode)) {
+		close(fd);
+		return -ENODEV;
+	}
+
+	if (info.st_size > 0) {
+		void *data = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (data == MAP_FAILED) {
+			close(fd);
+			return -ENOMEM;
+		}
+		posix_madvise(data, info.st_size, POSIX_MADV_SEQUENTIAL);
+
+		map->data   = data;
+		map->length = info.st_size;
+	}
+
+	// The mapping stays valid after the descriptor is closed
+	close(fd);
+
+	const int binary = map->length >= BNX_BINARY_HEADER
+		&& memcmp(map->data, bnx_binary_magic, sizeof(bnx_binary_magic)) == 0;
+
+	const int error = binary ? bnx_map_index_binary(map) : bnx_map_index(map);
+	if (error != 0) {
+		bnx_map_close(map);
+	}
+
+	return error;
+}
+
+struct Bnx *
+bnx_map_get(struct BnxMap const * const map, const size_t index,
+            struct Bnx *b)
+{
+	struct BnxReader r;
+
+#ifdef BNX_SAFETY_CHECKS
+	if (index >= map->count) {
+		bnx_free(b);
+		return NULL;
+	}
+#endif
+
+	if (map->binary) {
+		const unsigned char *p = (const unsigned char *)map->data
+			+ map->table + 8 * index;
+		const size_t offset = bnx_binary_load(p, 8);
+
+		if (offset > map->length
+		    || bnx_binary_record_size(map->size) > map->length - offset) {
+			fprintf(stderr, "Binoxxo %zu out of bounds\n", index);
+			bnx_free(b);
+			return NULL;
+		}
+
+		if (b == NULL || b->size != map->size) {
+			bnx_free(b);
+			b = bnx_alloc(map->size);
+			if (b == NULL) {
+				return NULL;
+			}
+		}
+
+		bnx_binary_unpack(b, (const unsigned char *)map->data + offset);
+		return b;
+	}
+
+	// The error was reported while indexing
+	if (map->entry[index].error != 0) {
+		bnx_free(b);
+		return NULL;
+	}
+
+	bnx_map_reader(map, &r, map->entry[index].offset, map->entry[index].line);
+
+	return bnx_reader_next(&r, b);
+}
+
+void
+bnx_map_close(struct BnxMap *map)
+{
+	if (map->data != NULL) {
+		munmap((void *)map->data, map->length);
+	}
+	free(map->entry);
+
+	memset(map, 0, sizeof(struct BnxMap));
+}
+
 struct Bnx *
 bnx_read_file(const char *filename)
 {
@@ -188,30 +718,36 @@ bnx_read_file(const char *filename)
 		return NULL;
 	}
 	
-	size_t size;
-	fscanf(file, "%zu", &size);
-	
-	// line size + \n + null
-	char *buffer = malloc(sizeof(char) * (size + 2));
-	if (buffer == NULL) {
-		fprintf(stderr, "Could not allocate memory\n");
-		return NULL;
-	}
+	struct BnxReader reader;
+	struct Bnx *b = NULL;
 
-	struct Bnx *b = bnx_alloc(size);
-	
-	int i;
-	for (i = 0; i < size; i++) {
-		fscanf(file, "%s\n", buffer);
-		bnx_parse_line(b, i, buffer);		
+	if (bnx_reader_init(&reader, file) == 0) {
+		b = bnx_reader_next(&reader, NULL);
+		bnx_reader_free(&reader);
 	}
-	
-	free(buffer);
+
 	fclose(file);
 	
 	return b;
 }
 
+void
+bnx_write_stream(FILE *file, struct Bnx const * const b)
+{
+	const size_t size = b->size;
+
+	fprintf(file, "%zu\n", size);
+
+	int row;
+	int col;
+	for (row = 0; row < size; row++) {
+		for (col = 0; col < size; col++) {
+			fputc(bnx_field_to_char(b->data[row][col]), file);
+		}
+		fputc('\n', file);
+	}
+}
+
 int
 bnx_write_file(struct Bnx const * const b, const char *filename)
 {
@@ -221,20 +757,300 @@ bnx_write_file(struct Bnx const * const b, const char *filename)
 		return 1;
 	}
 	
-	const size_t size = b->size;
-	
-	fprintf(file, "%zu\n", size);
+	bnx_write_stream(file, b);
 	
+	fclose(file);
+	return true;
+}
+
+int
+bnx_write_dimacs_stream(FILE *file, struct Bnx const * const b)
+{
+	struct BnxBoard *board = malloc(sizeof(struct BnxBoard));
+	struct BnxCnf cnf;
+	int error;
+
+	if (board == NULL) {
+		return -ENOMEM;
+	}
+
+	error = bnx_board_pack(board, b);
+	if (error == 0) {
+		bnx_cnf_init(&cnf, b->size);
+		error = bnx_cnf_encode(&cnf, board);
+	}
+	free(board);
+
+	if (error != 0) {
+		return error;
+	}
+
+	const size_t size = b->size;
 	int row;
 	int col;
+	fprintf(file, "c binoxxo %zux%zu\n", size, size);
+	fprintf(file, "c variables 1 to %zu are the fields, true for an x\n",
+		size * size);
 	for (row = 0; row < size; row++) {
 		for (col = 0; col < size; col++) {
-			fprintf(file, "%c", bnx_field_to_char(b->data[row][col]));
+			fprintf(file, "c field %d %d %d\n", row, col,
+				bnx_cnf_field(size, row, col));
 		}
-		fprintf(file, "\n");
 	}
-	
-	fclose(file);
-	return true;
+	fprintf(file, "p cnf %d %d\n", cnf.vars, cnf.clauses);
+
+	size_t i;
+	for (i = 0; i < cnf.length; i++) {
+		fprintf(file, cnf.lit[i] ? "%d " : "%d\n", cnf.lit[i]);
+	}
+
+	bnx_cnf_free(&cnf);
+
+	return ferror(file) ? -EIO : 0;
+}
+
+int
+bnx_write_dimacs(struct Bnx const * const b, const char *filename)
+{
+	FILE *file = fopen(filename, "w");
+	if (!file) {
+		fprintf(stderr, "Could not open file %s\n", filename);
+		return -ENOENT;
+	}
+
+	int error = bnx_write_dimacs_stream(file, b);
+	if (fclose(file) != 0 && error == 0) {
+		error = -EIO;
+	}
+
+	if (error != 0) {
+		remove(filename);
+	}
+
+	return error;
+}
+
+int
+bnx_read_model(struct Bnx const *b, const char *filename)
+{
+	const size_t fields = b->size * b->size;
+	FILE *file = strcmp(filename, "-") ? fopen(filename, "r") : stdin;
+	char *line = NULL;
+	size_t capacity = 0;
+	size_t found = 0;
+	int error = 0;
+	size_t i;
+
+	if (!file) {
+		fprintf(stderr, "Could not open file %s\n", filename);
+		return -ENOENT;
+	}
+
+	for (i = 0; i < fields; i++) {
+		b->data[0][i] = BNX_FIELD_EMPTY;
+	}
+
+	while (error == 0 && getline(&line, &capacity, file) != -1) {
+
+		char *p = line;
+		while (isspace((unsigned char)*p)) {
+			p++;
+		}
+
+		// Status lines, "s SATISFIABLE" or a bare "SAT"
+		if (*p == 'c' || *p == '\0') {
+			continue;
+		}
+		if (strstr(p, "UNSAT") != NULL) {
+			error = -ENOENT;
+			break;
+		}
+		if (*p == 's' || strncmp(p, "SAT", 3) == 0) {
+			continue;
+		}
+		if (*p == 'v') {
+			p++;
+		}
+
+		for (;;) {
+			char *end;
+			const long lit = strtol(p, &end, 10);
+			if (end == p) {
+				break;
+			}
+			p = end;
+
+			const size_t var = lit < 0 ? -lit : lit;
+			if (var == 0 || var > fields) {
+				continue;
+			}
+
+			int *field = &b->data[0][var - 1];
+			if (*field == BNX_FIELD_EMPTY) {
+				found++;
+			}
+			*field = lit > 0 ? BNX_FIELD_X : BNX_FIELD_O;
+		}
+
+		while (isspace((unsigned char)*p)) {
+			p++;
+		}
+		if (*p != '\0') {
+			fprintf(stderr, "Invalid model line: %s", line);
+			error = -EINVAL;
+		}
+	}
+
+	free(line);
+	if (file != stdin) {
+		fclose(file);
+	}
+
+	if (error == 0 && found != fields) {
+		fprintf(stderr, "Model misses %zu fields\n", fields - found);
+		error = -EINVAL;
+	}
+
+	return error;
+}
+
+int
+bnx_writer_init(struct BnxWriter *w, FILE *file)
+{
+	unsigned char header[BNX_BINARY_HEADER] = {0};
+
+	memset(w, 0, sizeof(struct BnxWriter));
+	w->file     = file;
+	w->position = BNX_BINARY_HEADER;
+
+	// The header is completed by bnx_writer_finish
+	if (fwrite(header, 1, sizeof(header), file) != sizeof(header)) {
+		return -EIO;
+	}
+
+	return 0;
+}
+
+int
+bnx_writer_add(struct BnxWriter *w, struct Bnx const * const b)
+{
+	unsigned char record[BNX_MAX_SIZE * BNX_MAX_SIZE / 4];
+
+	if (w->count == 0) {
+		w->size = b->size;
+	} else if (b->size != w->size) {
+		fprintf(stderr, "All binoxxos of a binary file must have size "
+			"%zu\n", w->size);
+		return -EINVAL;
+	}
+
+	if (w->count == w->capacity) {
+		const size_t capacity = w->capacity ? 2 * w->capacity : 1024;
+		uint64_t *offset = realloc(w->offset, capacity * sizeof(uint64_t));
+		if (offset == NULL) {
+			fprintf(stderr, "Could not allocate offset table\n");
+			return -ENOMEM;
+		}
+		w->offset   = offset;
+		w->capacity = capacity;
+	}
+
+	const size_t length = bnx_binary_record_size(b->size);
+
+	bnx_binary_pack(record, b);
+	if (fwrite(record, 1, length, w->file) != length) {
+		return -EIO;
+	}
+
+	w->offset[w->count++] = w->position;
+	w->position += length;
+
+	return 0;
 }
 
+int
+bnx_writer_finish(struct BnxWriter *w)
+{
+	unsigned char header[BNX_BINARY_HEADER] = {0};
+	unsigned char entry[8];
+	int error = 0;
+	size_t i;
+
+	for (i = 0; i < w->count && error == 0; i++) {
+		bnx_binary_store(entry, w->offset[i], sizeof(entry));
+		if (fwrite(entry, 1, sizeof(entry), w->file) != sizeof(entry)) {
+			error = -EIO;
+		}
+	}
+
+	memcpy(header, bnx_binary_magic, sizeof(bnx_binary_magic));
+	bnx_binary_store(header + BNX_BINARY_VERSION_AT, BNX_BINARY_VERSION, 2);
+	bnx_binary_store(header + BNX_BINARY_SIZE_AT, w->size, 2);
+	bnx_binary_store(header + BNX_BINARY_COUNT_AT, w->count, 8);
+	bnx_binary_store(header + BNX_BINARY_TABLE_AT, w->position, 8);
+
+	if (error == 0 && (fseek(w->file, 0, SEEK_SET) != 0
+	    || fwrite(header, 1, sizeof(header), w->file) != sizeof(header))) {
+		error = -EIO;
+	}
+
+	free(w->offset);
+	w->offset = NULL;
+
+	return error;
+}
+
+int
+bnx_convert_file(const char *input, const char *output)
+{
+	struct BnxMap map;
+	struct BnxWriter writer;
+	struct Bnx *b = NULL;
+	int error = bnx_map_open(&map, input);
+
+	if (error != 0) {
+		return error;
+	}
+
+	FILE *file = fopen(output, "wb");
+	if (!file) {
+		fprintf(stderr, "Could not open file %s\n", output);
+		bnx_map_close(&map);
+		return -ENOENT;
+	}
+
+	// Binary files become text and text files become binary
+	if (!map.binary) {
+		error = bnx_writer_init(&writer, file);
+	}
+
+	size_t i;
+	for (i = 0; i < map.count && error == 0; i++) {
+		b = bnx_map_get(&map, i, b);
+		if (b == NULL) {
+			error = -EINVAL;
+		} else if (map.binary) {
+			bnx_write_stream(file, b);
+		} else {
+			error = bnx_writer_add(&writer, b);
+		}
+	}
+
+	if (!map.binary) {
+		const int finish = bnx_writer_finish(&writer);
+		error = error ? error : finish;
+	}
+
+	bnx_free(b);
+	if (fclose(file) != 0 && error == 0) {
+		error = -EIO;
+	}
+	bnx_map_close(&map);
+
+	// Do not leave truncated files behind
+	if (error != 0) {
+		remove(output);
+	}
+
+	return error;
+}
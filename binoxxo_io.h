@@ -22,17 +22,109 @@
 
 #include <ctype.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
 #include "binoxxo.h"
+#include "binoxxo_solver_ctx.h"
 
 ///
 /// Define default buffer size
 ///
 extern const size_t bnx_buffer_size;
 
+///
+/// Size of the read buffer of a stream reader
+///
+extern const size_t bnx_reader_buffer_size;
+
+///
+/// First bytes of a binary file
+///
+extern const char bnx_binary_magic[4];
+
+///
+/// Version of the binary format written by bnx_writer_finish
+///
+#define BNX_BINARY_VERSION 1
+
+///
+/// Buffered reader for a stream of binoxxos
+///
+/// 	A stream holds any number of binoxxos in the format of
+/// 	bnx_read_file, one after another. Whitespace separates the size and
+/// 	the rows, everything from a '#' to the end of a line is a comment.
+/// 	After a syntax error reading goes on at the next line starting with
+/// 	a digit, the size of the next binoxxo.
+///
+struct BnxReader {
+	FILE *file;
+	char *buffer;
+	size_t length;		// Bytes in buffer
+	size_t pos;			// Next byte to parse
+	size_t line;		// Current line, for error messages
+	int error;			// Error of the last binoxxo, 0 at the end
+};
+
+///
+/// Start of a binoxxo inside a mapped file
+///
+struct BnxMapEntry {
+	size_t offset;
+	size_t line;
+	int error;			// Syntax error found while indexing
+};
+
+///
+/// Stream of binoxxos mapped into memory, with the offset of every binoxxo.
+/// Binoxxos are parsed straight from the mapped bytes, so threads can
+/// parse disjoint entries of one map without any lock.
+///
+/// 	Binary files bring their own offset table and are not indexed:
+///
+/// 	A header of 24 bytes holds the magic "BNXB", the 16 bit version, the
+/// 	16 bit size of all binoxxos, the 64 bit count and the 64 bit position
+/// 	of the offset table, all little endian. Every binoxxo is a record of
+/// 	2 bits per field, row by row and starting at the lowest bits of a
+/// 	byte, with 0 for empty, 1 for 'o' and 2 for 'x'. The offset table
+/// 	holds the 64 bit position of every record.
+///
+struct BnxMap {
+	const char *data;
+	size_t length;
+	struct BnxMapEntry *entry;		// Index of text files
+	size_t count;
+	int binary;
+	size_t size;					// Size of all binoxxos of binary files
+	size_t table;					// Position of the offset table
+};
+
+///
+/// Writer of binary files, see struct BnxMap for the format
+///
+struct BnxWriter {
+	FILE *file;
+	size_t size;
+	uint64_t *offset;
+	size_t count;
+	size_t capacity;
+	uint64_t position;				// Position of the next record
+};
+
+///
+/// \brief Bytes of a binary record
+///
+/// \param Size
+/// \return Bytes
+///
+static inline size_t
+bnx_binary_record_size(const size_t size)
+{
+	return (2 * size * size + 7) / 8;
+}
+
 ///
 /// \brief Print binoxxo to console
 ///
@@ -49,6 +141,24 @@ bnx_print(struct Bnx const * const);
 void
 bnx_line_print(struct BnxLine const * const);
 
+///
+/// \brief Print statistics of a search as JSON
+///
+/// \param Stream
+/// \param Statistics
+///
+void
+bnx_stats_print(FILE *, struct BnxStats const * const);
+
+///
+/// \brief Write a binoxxo to a stream in the format of bnx_read_file
+///
+/// \param Stream
+/// \param Binoxxo data structure
+///
+void
+bnx_write_stream(FILE *, struct Bnx const * const);
+
 ///
 /// \brief Fill binoxxo data structure with user input
 ///
@@ -74,6 +184,81 @@ bnx_fill_by_input(void);
 struct Bnx *
 bnx_read_file(const char *);
 
+///
+/// \brief Initialize a reader on an open stream
+///
+/// \param Reader
+/// \param Stream, stays owned by the caller
+/// \return Error
+///
+int
+bnx_reader_init(struct BnxReader *, FILE *);
+
+///
+/// \brief Read the next binoxxo of a stream in one pass over the buffer
+///
+/// \param Reader
+/// \param Binoxxo to reuse if it has the same size, freed otherwise.
+/// 	May be NULL.
+/// \return Binoxxo data structure, NULL at the end or on errors. The
+/// 	error of the reader tells them apart, after an error the next call
+/// 	reads the following binoxxo.
+///
+struct Bnx *
+bnx_reader_next(struct BnxReader *, struct Bnx *);
+
+///
+/// \brief Read a non-negative number, for formats which put counts
+/// 	between the binoxxos of a stream
+///
+/// \param Reader
+/// \param Number
+/// \return Error, -ENOENT at the end of the stream
+///
+int
+bnx_reader_number(struct BnxReader *, size_t *);
+
+///
+/// \brief Free the buffer of a reader
+///
+/// \param Reader
+///
+void
+bnx_reader_free(struct BnxReader *);
+
+///
+/// \brief Map a regular file holding a stream of binoxxos and index the
+/// 	start of every binoxxo. Like a stream reader the index goes on after
+/// 	a syntax error, the entry of the broken binoxxo keeps the error.
+/// 	Binary files are detected by their magic.
+///
+/// \param Map
+/// \param Filename
+/// \return Error, -ENODEV if the file is not a regular file
+///
+int
+bnx_map_open(struct BnxMap *, const char *);
+
+///
+/// \brief Parse a binoxxo of a map
+///
+/// \param Map
+/// \param Index of the binoxxo
+/// \param Binoxxo to reuse if it has the same size, freed otherwise.
+/// 	May be NULL.
+/// \return Binoxxo data structure, NULL on errors
+///
+struct Bnx *
+bnx_map_get(struct BnxMap const * const, const size_t, struct Bnx *);
+
+///
+/// \brief Unmap a file and free its index
+///
+/// \param Map
+///
+void
+bnx_map_close(struct BnxMap *);
+
 ///
 /// \brief Fill binoxxo data structure with user input
 ///
@@ -84,5 +269,82 @@ bnx_read_file(const char *);
 int
 bnx_write_file(struct Bnx const * const, const char *);
 
-#endif // BINOXXO_INPUT_H
+///
+/// \brief Start a binary file by writing a header placeholder
+///
+/// \param Writer
+/// \param Stream, must be seekable and stays owned by the caller
+/// \return Error
+///
+int
+bnx_writer_init(struct BnxWriter *, FILE *);
 
+///
+/// \brief Append a binoxxo to a binary file, all binoxxos of a file must
+/// 	have the same size
+///
+/// \param Writer
+/// \param Binoxxo data structure
+/// \return Error
+///
+int
+bnx_writer_add(struct BnxWriter *, struct Bnx const * const);
+
+///
+/// \brief Write the offset table and the header of a binary file
+///
+/// \param Writer
+/// \return Error
+///
+int
+bnx_writer_finish(struct BnxWriter *);
+
+///
+/// \brief Convert a text file into a binary file or a binary file into a
+/// 	text file
+///
+/// \param Input filename
+/// \param Output filename
+/// \return Error
+///
+int
+bnx_convert_file(const char *, const char *);
+
+///
+/// \brief Write the rules and givens of a binoxxo as DIMACS CNF, with the
+/// 	encoding of bnx_cnf_encode
+///
+/// 	Comment lines map the variables, "c field row column variable" for
+/// 	every field. A field variable is true for an x, all variables after
+/// 	the fields are auxiliary.
+///
+/// \param Stream
+/// \param Binoxxo data structure
+/// \return Error
+///
+int
+bnx_write_dimacs_stream(FILE *, struct Bnx const * const);
+
+///
+/// \brief Write a binoxxo as DIMACS CNF file, see bnx_write_dimacs_stream
+///
+/// \param Binoxxo data structure
+/// \param Filename
+/// \return Error
+///
+int
+bnx_write_dimacs(struct Bnx const * const, const char *);
+
+///
+/// \brief Fill a binoxxo from the model a SAT solver found for its DIMACS
+/// 	CNF. Both the competition format with "s" and "v" lines and plain
+/// 	lists of literals are read, comments are skipped.
+///
+/// \param Binoxxo data structure, its size selects the field variables
+/// \param Filename of the model, "-" for stdin
+/// \return Error, -ENOENT if the solver found no model
+///
+int
+bnx_read_model(struct Bnx const *, const char *);
+
+#endif // BINOXXO_INPUT_H
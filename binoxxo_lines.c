@@ -0,0 +1,292 @@
+// 
+// binoxxo_lines.c
+// Copyright (C) 2014  Florian Tanner <florian.tanner@gmail.com>
+// 
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+// 
+
+
+
+#include <pthread.h>
+
+#include "binoxxo_lines.h"
+
+///
+/// Number of legal lines of all tabulated sizes together
+///
+#define BNX_LINES_CAPACITY 2160
+
+///
+/// Number of legal lines of the sizes with specialized scans
+///
+#define BNX_LINES_COUNT_6 14
+#define BNX_LINES_COUNT_8 34
+#define BNX_LINES_COUNT_10 84
+#define BNX_LINES_COUNT_12 208
+#define BNX_LINES_COUNT_14 518
+
+static BnxMask bnx_lines_table[BNX_LINES_CAPACITY];
+static BnxMask *bnx_lines_start[BNX_LINES_MAX_SIZE + 1];
+static uint16_t bnx_lines_narrow[BNX_LINES_CAPACITY];	// Same lines, 16 bit
+static size_t bnx_lines_count[BNX_LINES_MAX_SIZE + 1];
+static pthread_once_t bnx_lines_once = PTHREAD_ONCE_INIT;
+
+static void
+bnx_lines_build(BnxMask **out, const size_t size, const size_t pos,
+                const BnxMask x, const int count_x)
+{
+	const int half = size / 2;
+
+	if (count_x > half || pos - count_x > half) {
+		return;
+	}
+
+	if (pos == size) {
+		*(*out)++ = x;
+		return;
+	}
+
+	// Next field would be the third equal one in a row
+	int after_xx = false;
+	int after_oo = false;
+	if (pos >= 2) {
+		const BnxMask last = (x >> (pos - 2)) & 3;
+		after_xx = last == 3;
+		after_oo = last == 0;
+	}
+
+	if (!after_oo) {
+		bnx_lines_build(out, size, pos + 1, x, count_x);
+	}
+	if (!after_xx) {
+		bnx_lines_build(out, size, pos + 1, x | (BnxMask)1 << pos,
+		                count_x + 1);
+	}
+}
+
+static void
+bnx_lines_build_all(void)
+{
+	BnxMask *out = bnx_lines_table;
+	size_t size;
+
+	for (size = bnx_min_size; size <= BNX_LINES_MAX_SIZE; size += 2) {
+		bnx_lines_start[size] = out;
+		bnx_lines_build(&out, size, 0, 0, 0);
+		bnx_lines_count[size] = out - bnx_lines_start[size];
+	}
+
+	// Tabulated lines fit 16 bit, scans can work on narrow masks
+	size_t i;
+	for (i = 0; i < out - bnx_lines_table; i++) {
+		bnx_lines_narrow[i] = bnx_lines_table[i];
+	}
+}
+
+void
+bnx_lines_init(void)
+{
+	pthread_once(&bnx_lines_once, &bnx_lines_build_all);
+}
+
+size_t
+bnx_lines_get(const size_t size, BnxMask const **lines)
+{
+	// Counts stay 0 until bnx_lines_init
+	if (size > BNX_LINES_MAX_SIZE || size % 2 != 0) {
+		return 0;
+	}
+
+	*lines = bnx_lines_start[size];
+	return bnx_lines_count[size];
+}
+
+static int
+bnx_lines_is_used(struct BnxBoard const * const board, const int dir,
+                  const int index, const BnxMask x)
+{
+	const size_t size = board->size;
+	int i;
+
+	for (i = 0; i < size; i++) {
+		if (i != index && board->x[dir][i] == x
+		    && board->o[dir][i] == (board->full & ~x)) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+static int
+bnx_lines_apply(struct BnxBits *line, const BnxMask empty, const BnxMask all_x,
+                const BnxMask any_x, const int matches)
+{
+	if (matches == 0) {
+		// No legal line left
+		line->o |= empty;
+		line->x |= empty;
+		return true;
+	}
+
+	const BnxMask add_x = all_x & empty;
+	const BnxMask add_o = ~any_x & empty;
+
+	line->o |= add_o;
+	line->x |= add_x;
+
+	return (add_o | add_x) != 0;
+}
+
+static int
+bnx_lines_scan_exact(struct BnxBoard const * const board, const int dir,
+                     const int index, struct BnxBits *line)
+{
+	BnxMask const *lines;
+	const size_t count = bnx_lines_get(line->size, &lines);
+	const BnxMask empty = line->full & ~(line->o | line->x);
+	BnxMask all_x = line->full;		// Fields that are x in every match
+	BnxMask any_x = 0;				// Fields that are x in some match
+	int matches = 0;
+	int i;
+
+	for (i = 0; i < count; i++) {
+
+		const BnxMask x = lines[i];
+		if ((x & line->x) != line->x || (x & line->o) != 0) {
+			continue;
+		}
+
+		if (bnx_lines_is_used(board, dir, index, x)) {
+			continue;
+		}
+
+		all_x &= x;
+		any_x |= x;
+		matches++;
+	}
+
+	return bnx_lines_apply(line, empty, all_x, any_x, matches);
+}
+
+static int
+bnx_lines_any_used(struct BnxBoard const * const board, const int dir,
+                   const int index, struct BnxBits const * const line)
+{
+	const size_t size = board->size;
+	int i;
+
+	for (i = 0; i < size; i++) {
+		const BnxMask x = board->x[dir][i];
+		if (i != index && board->o[dir][i] == (board->full & ~x)
+		    && (x & line->x) == line->x && (x & line->o) == 0) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+///
+/// \brief Scan with the size and the number of legal lines known at compile
+/// 	time. The match loop has no branches, so it can be unrolled and
+/// 	vectorized. Matching lines that are used elsewhere are rare, they are
+/// 	handled by an exact scan.
+///
+static inline __attribute__((always_inline)) int
+bnx_lines_scan_sized(struct BnxBoard const * const board, const int dir,
+                     const int index, struct BnxBits *line, const size_t size,
+                     const size_t count)
+{
+	const uint16_t *lines = bnx_lines_narrow
+		+ (bnx_lines_start[size] - bnx_lines_table);
+	const unsigned int full = ((unsigned int)1 << size) - 1;
+	const unsigned int lx = line->x;
+	const unsigned int lo = line->o;
+	const BnxMask empty = full & ~(lo | lx);
+	unsigned int all_x = full;
+	unsigned int any_x = 0;
+	unsigned int matches = 0;
+	size_t i;
+
+	if (empty == 0) {
+		return false;
+	}
+
+	for (i = 0; i < count; i++) {
+		const unsigned int x = lines[i];
+		const unsigned int match = ((x & lx) == lx) & ((x & lo) == 0);
+		const unsigned int select = -match;
+
+		all_x &= x | ~select;
+		any_x |= x & select;
+		matches += match;
+	}
+
+	if (matches > 0 && bnx_lines_any_used(board, dir, index, line)) {
+		return bnx_lines_scan_exact(board, dir, index, line);
+	}
+
+	return bnx_lines_apply(line, empty, all_x, any_x, matches);
+}
+
+///
+/// \brief Instantiate a scan for one size
+///
+#define BNX_LINES_SCAN(n) \
+static int \
+bnx_lines_scan_##n(struct BnxBoard const * const board, const int dir, \
+                   const int index, struct BnxBits *line) \
+{ \
+	return bnx_lines_scan_sized(board, dir, index, line, n, \
+	                            BNX_LINES_COUNT_##n); \
+}
+
+BNX_LINES_SCAN(6)
+BNX_LINES_SCAN(8)
+BNX_LINES_SCAN(10)
+BNX_LINES_SCAN(12)
+BNX_LINES_SCAN(14)
+
+int
+bnx_lines_scan(struct BnxBoard const * const board, const int dir,
+               const int index, struct BnxBits *line)
+{
+	BnxMask const *lines;
+	const size_t count = bnx_lines_get(line->size, &lines);
+
+	switch (count > 0 ? line->size : 0) {
+		case 6:
+			return bnx_lines_scan_6(board, dir, index, line);
+
+		case 8:
+			return bnx_lines_scan_8(board, dir, index, line);
+
+		case 10:
+			return bnx_lines_scan_10(board, dir, index, line);
+
+		case 12:
+			return bnx_lines_scan_12(board, dir, index, line);
+
+		case 14:
+			return bnx_lines_scan_14(board, dir, index, line);
+
+		case 0:
+			return false;
+
+		default:
+			return bnx_lines_scan_sized(board, dir, index, line, line->size,
+			                            count);
+	}
+}
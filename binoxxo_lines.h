@@ -0,0 +1,67 @@
+// 
+// binoxxo_lines.h
+// Copyright (C) 2014  Florian Tanner <florian.tanner@gmail.com>
+// 
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+// 
+
+
+
+#ifndef BINOXXO_LINES_H
+#define BINOXXO_LINES_H
+
+#include "binoxxo.h"
+#include "binoxxo_board.h"
+
+///
+/// Largest size for which all legal lines are tabulated
+/// (1296 lines for size 16, the count grows by ~2.5 per step)
+///
+#define BNX_LINES_MAX_SIZE 16
+
+///
+/// \brief Build the tables of all legal lines, a line is legal if it is
+/// 	balanced and has no triples. Only the first call does any work,
+/// 	concurrent first calls wait until the tables are built.
+///
+void
+bnx_lines_init(void);
+
+///
+/// \brief Get the table of legal lines of a size
+///
+/// \param Size
+/// \param Table, receives the x masks of all legal lines
+/// \return Number of lines, 0 if the size is not tabulated
+///
+size_t
+bnx_lines_get(const size_t, BnxMask const **);
+
+///
+/// \brief Intersect a line with all legal lines that match its fields and
+/// 	are not used as complete line elsewhere, then set every empty field
+/// 	on which all of them agree. If no legal line is left, the empty
+/// 	fields are set to 'o' and 'x' to mark the conflict.
+///
+/// \param Board holding the line
+/// \param Direction
+/// \param Index
+/// \param Line
+/// \return Modified
+///
+int
+bnx_lines_scan(struct BnxBoard const * const, const int, const int,
+               struct BnxBits *);
+
+#endif // BINOXXO_LINES_H
@@ -0,0 +1,406 @@
+// 
+// binoxxo_parallel.c
+// Copyright (C) 2014  Florian Tanner <florian.tanner@gmail.com>
+// 
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+// 
+
+
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <unistd.h>
+
+#include "binoxxo_parallel.h"
+
+///
+/// Tasks of a thread, the owner works at the tail and thieves at the head
+///
+struct BnxDeque {
+	pthread_mutex_t lock;
+	struct BnxBoard **task;
+	size_t capacity;
+	size_t head;
+	size_t tail;
+};
+
+struct BnxPool;
+
+///
+/// Thread taking part in a parallel search
+///
+struct BnxWorker {
+	struct BnxPool *pool;
+	struct BnxDeque deque;
+	struct BnxSolverCtx *ctx;
+	pthread_t thread;
+	int id;
+};
+
+///
+/// All threads of a parallel search
+///
+struct BnxPool {
+	struct BnxWorker *worker;
+	int workers;
+	atomic_long pending;			// Tasks pushed but not finished yet
+	atomic_ulong pushed;			// Tasks pushed so far
+	atomic_int idle;				// Threads waiting for a task
+	pthread_mutex_t lock;
+	pthread_cond_t wake;			// A task was pushed or all are done
+};
+
+static void
+bnx_deque_init(struct BnxDeque *d)
+{
+	pthread_mutex_init(&d->lock, NULL);
+	d->task     = NULL;
+	d->capacity = 0;
+	d->head     = 0;
+	d->tail     = 0;
+}
+
+static void
+bnx_deque_free(struct BnxDeque *d)
+{
+	// Remaining tasks are released with the arenas of the contexts
+	free(d->task);
+	pthread_mutex_destroy(&d->lock);
+}
+
+static size_t
+bnx_deque_size(struct BnxDeque *d)
+{
+	pthread_mutex_lock(&d->lock);
+	const size_t size = d->tail - d->head;
+	pthread_mutex_unlock(&d->lock);
+
+	return size;
+}
+
+static int
+bnx_deque_push(struct BnxDeque *d, struct BnxBoard *task)
+{
+	int pushed = true;
+
+	pthread_mutex_lock(&d->lock);
+
+	if (d->tail == d->capacity && d->head > 0) {
+		// Reuse the space in front of the head before growing
+		const size_t size = d->tail - d->head;
+		memmove(d->task, d->task + d->head, size * sizeof(struct BnxBoard *));
+		d->head = 0;
+		d->tail = size;
+	}
+
+	if (d->tail == d->capacity) {
+		const size_t capacity = d->capacity ? 2 * d->capacity : 16;
+		struct BnxBoard **task = realloc(d->task,
+			capacity * sizeof(struct BnxBoard *));
+		if (task == NULL) {
+			pushed = false;
+		} else {
+			d->task     = task;
+			d->capacity = capacity;
+		}
+	}
+
+	if (pushed) {
+		d->task[d->tail++] = task;
+	}
+
+	pthread_mutex_unlock(&d->lock);
+
+	return pushed;
+}
+
+static struct BnxBoard *
+bnx_deque_pop(struct BnxDeque *d)
+{
+	struct BnxBoard *task = NULL;
+
+	pthread_mutex_lock(&d->lock);
+	if (d->tail > d->head) {
+		task = d->task[--d->tail];
+	}
+	pthread_mutex_unlock(&d->lock);
+
+	return task;
+}
+
+static struct BnxBoard *
+bnx_deque_steal(struct BnxDeque *d)
+{
+	struct BnxBoard *task = NULL;
+
+	pthread_mutex_lock(&d->lock);
+	if (d->tail > d->head) {
+		task = d->task[d->head++];
+	}
+	pthread_mutex_unlock(&d->lock);
+
+	return task;
+}
+
+///
+/// \brief Wake threads waiting for a task
+///
+/// \param Pool
+/// \param True to wake all of them
+///
+static void
+bnx_pool_wake(struct BnxPool *pool, const int all)
+{
+	pthread_mutex_lock(&pool->lock);
+	if (all) {
+		pthread_cond_broadcast(&pool->wake);
+	} else {
+		pthread_cond_signal(&pool->wake);
+	}
+	pthread_mutex_unlock(&pool->lock);
+}
+
+static int
+bnx_parallel_spawn(struct BnxSolverCtx *ctx, const int row, const int col,
+                   const int field)
+{
+	struct BnxWorker *w = ctx->worker;
+
+	if (w->pool->workers == 1 || bnx_deque_size(&w->deque) >= BNX_SPAWN_LIMIT) {
+		return false;
+	}
+
+	struct BnxBoard *task = bnx_arena_get(&ctx->arena);
+	if (task == NULL) {
+		return false;
+	}
+
+	bnx_board_copy(task, ctx->board);
+	bnx_board_set(task, row, col, field);
+
+	atomic_fetch_add(&w->pool->pending, 1);
+	if (!bnx_deque_push(&w->deque, task)) {
+		atomic_fetch_sub(&w->pool->pending, 1);
+		bnx_arena_put(&ctx->arena, task);
+		return false;
+	}
+
+	// A thread going idle counts itself before it checks pushed, so either
+	// it sees this task or it is counted here
+	atomic_fetch_add(&w->pool->pushed, 1);
+	if (atomic_load(&w->pool->idle) > 0) {
+		bnx_pool_wake(w->pool, false);
+	}
+
+	// Every thread owns a board, every pending task holds one more
+	BNX_STATS_MAX(&ctx->stats, boards,
+	              (unsigned long)(w->pool->workers
+	                              + atomic_load(&w->pool->pending)));
+
+	return true;
+}
+
+static struct BnxBoard *
+bnx_parallel_steal(struct BnxWorker *w)
+{
+	struct BnxPool *pool = w->pool;
+	int i;
+
+	for (i = 1; i < pool->workers; i++) {
+		const int victim = (w->id + i) % pool->workers;
+		struct BnxBoard *task = bnx_deque_steal(&pool->worker[victim].deque);
+		if (task != NULL) {
+			return task;
+		}
+	}
+
+	return NULL;
+}
+
+static void *
+bnx_parallel_run(void *arg)
+{
+	struct BnxWorker *w = arg;
+	struct BnxPool *pool = w->pool;
+	struct BnxSolverCtx *ctx = w->ctx;
+
+	while (atomic_load(&pool->pending) > 0) {
+
+		const unsigned long pushed = atomic_load(&pool->pushed);
+
+		struct BnxBoard *task = bnx_deque_pop(&w->deque);
+		if (task == NULL) {
+			task = bnx_parallel_steal(w);
+		}
+		if (task == NULL) {
+			// Sleep until a task is pushed after the search above or the
+			// last task is done
+			pthread_mutex_lock(&pool->lock);
+			atomic_fetch_add(&pool->idle, 1);
+			while (atomic_load(&pool->pending) > 0
+			       && atomic_load(&pool->pushed) == pushed) {
+				pthread_cond_wait(&pool->wake, &pool->lock);
+			}
+			atomic_fetch_sub(&pool->idle, 1);
+			pthread_mutex_unlock(&pool->lock);
+			continue;
+		}
+
+		// Once all slots are used up the remaining tasks are only dropped
+		if (!bnx_collector_done(ctx->collector)) {
+			bnx_board_copy(ctx->board, task);
+			bnx_solve_ctx(ctx);
+		}
+
+		// Stolen boards move to the arena of the thief
+		bnx_arena_put(&ctx->arena, task);
+		if (atomic_fetch_sub(&pool->pending, 1) == 1) {
+			bnx_pool_wake(pool, true);
+		}
+	}
+
+	return NULL;
+}
+
+static void
+bnx_pool_free(struct BnxPool *pool)
+{
+	int i;
+	for (i = 0; i < pool->workers; i++) {
+		bnx_deque_free(&pool->worker[i].deque);
+		if (pool->worker[i].ctx != NULL) {
+			bnx_ctx_free(pool->worker[i].ctx);
+		}
+	}
+	free(pool->worker);
+	pthread_cond_destroy(&pool->wake);
+	pthread_mutex_destroy(&pool->lock);
+}
+
+static int
+bnx_pool_init(struct BnxPool *pool, struct Bnx const * const b,
+              const int mode, struct BnxCollector *collector,
+              const int threads)
+{
+	pool->workers = threads;
+	atomic_init(&pool->pending, 0);
+	atomic_init(&pool->pushed, 0);
+	atomic_init(&pool->idle, 0);
+
+	pool->worker = calloc(threads, sizeof(struct BnxWorker));
+	if (pool->worker == NULL) {
+		fprintf(stderr, "Could not allocate memory for threads\n");
+		return -ENOMEM;
+	}
+
+	pthread_mutex_init(&pool->lock, NULL);
+	pthread_cond_init(&pool->wake, NULL);
+
+	int i;
+	for (i = 0; i < threads; i++) {
+		struct BnxWorker *w = &pool->worker[i];
+
+		bnx_deque_init(&w->deque);
+		w->pool = pool;
+		w->id   = i;
+		w->ctx  = bnx_ctx_alloc(b, mode, collector);
+		if (w->ctx == NULL) {
+			pool->workers = i + 1;
+			bnx_pool_free(pool);
+			return -ENOMEM;
+		}
+
+		w->ctx->spawn  = &bnx_parallel_spawn;
+		w->ctx->worker = w;
+
+		// Every worker draws its own sequence of random guesses
+		bnx_ctx_seed(w->ctx, BNX_RANDOM_SEED + i);
+	}
+
+	return 0;
+}
+
+struct BnxSolution *
+bnx_solve_parallel(struct Bnx const * const b, const int mode,
+                   const int sol_mode, int threads, struct BnxStats *stats)
+{
+	struct BnxCollector collector;
+	struct BnxPool pool;
+
+	if (threads <= 0) {
+		threads = sysconf(_SC_NPROCESSORS_ONLN);
+		if (threads <= 0) {
+			threads = 1;
+		}
+	}
+
+	bnx_lines_init();
+	bnx_collector_init(&collector, sol_mode);
+
+	if (bnx_pool_init(&pool, b, mode, &collector, threads) != 0) {
+		bnx_collector_destroy(&collector);
+		return NULL;
+	}
+
+	// The whole binoxxo is the first task
+	struct BnxBoard *root = bnx_arena_get(&pool.worker[0].ctx->arena);
+	if (root == NULL) {
+		bnx_pool_free(&pool);
+		bnx_collector_destroy(&collector);
+		return NULL;
+	}
+	bnx_board_copy(root, pool.worker[0].ctx->board);
+	atomic_store(&pool.pending, 1);
+	bnx_deque_push(&pool.worker[0].deque, root);
+
+#ifdef BNX_TIMING
+	struct timespec start;
+	timespec_get(&start, TIME_UTC);
+#endif
+
+	int i;
+	int started = 1;
+	for (i = 1; i < threads; i++) {
+		if (pthread_create(&pool.worker[i].thread, NULL, &bnx_parallel_run,
+		                   &pool.worker[i]) != 0) {
+			break;
+		}
+		started++;
+	}
+
+	// The calling thread works as well
+	bnx_parallel_run(&pool.worker[0]);
+
+	for (i = 1; i < started; i++) {
+		pthread_join(pool.worker[i].thread, NULL);
+	}
+
+#ifdef BNX_TIMING
+	struct timespec end;
+	timespec_get(&end, TIME_UTC);
+	printf("Time: %.2f s (%d threads)\n", (double)(end.tv_sec - start.tv_sec)
+		+ (double)(end.tv_nsec - start.tv_nsec) / 1e9, started);
+#endif
+
+	if (stats != NULL) {
+		memset(stats, 0, sizeof(struct BnxStats));
+		for (i = 0; i < pool.workers; i++) {
+			bnx_stats_merge(stats, &pool.worker[i].ctx->stats);
+		}
+	}
+
+	bnx_pool_free(&pool);
+
+	return bnx_collector_destroy(&collector);
+}
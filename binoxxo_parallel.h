@@ -0,0 +1,53 @@
+// 
+// binoxxo_parallel.h
+// Copyright (C) 2014  Florian Tanner <florian.tanner@gmail.com>
+// 
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+// 
+
+
+
+#ifndef BINOXXO_PARALLEL_H
+#define BINOXXO_PARALLEL_H
+
+#include "binoxxo.h"
+#include "binoxxo_solver.h"
+
+///
+/// A thread only hands out branches while it has fewer queued tasks
+///
+#define BNX_SPAWN_LIMIT 4
+
+///
+/// \brief Solve a binoxxo with several threads
+///
+/// 	Every thread runs the same search as bnx_solve on its own board. At
+/// 	a guess the second branch is pushed as a task onto the deque of the
+/// 	thread, unless enough tasks are waiting there. Threads take their
+/// 	newest task first and steal the oldest task of another thread when
+/// 	their deque runs empty. The search stops as soon as all solution
+/// 	slots are used up.
+///
+/// \param Binoxxo data structure
+/// \param Guess mode
+/// \param Solution mode
+/// \param Number of threads, 0 for one per processor
+/// \param Statistics of all threads, may be NULL
+/// \return Solutions
+///
+struct BnxSolution *
+bnx_solve_parallel(struct Bnx const * const, const int, const int, int,
+                   struct BnxStats *);
+
+#endif // BINOXXO_PARALLEL_H
@@ -0,0 +1,99 @@
+// 
+// binoxxo_random.h
+// Copyright (C) 2014  Florian Tanner <florian.tanner@gmail.com>
+// 
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+// 
+
+
+
+#ifndef BINOXXO_RANDOM_H
+#define BINOXXO_RANDOM_H
+
+#include <stdint.h>
+
+///
+/// Seed used if none is given
+///
+#define BNX_RANDOM_SEED 0x2545F4914F6CDD1Dull
+
+///
+/// State of a xoshiro256** generator, every thread or context owns one
+///
+struct BnxRandom {
+	uint64_t s[4];
+};
+
+static inline uint64_t
+bnx_random_rotl(const uint64_t x, const int k)
+{
+	return (x << k) | (x >> (64 - k));
+}
+
+///
+/// \brief Seed a generator, the state is expanded with splitmix64
+///
+/// \param Generator
+/// \param Seed
+///
+static inline void
+bnx_random_seed(struct BnxRandom *r, uint64_t seed)
+{
+	int i;
+
+	for (i = 0; i < 4; i++) {
+		uint64_t z = (seed += 0x9E3779B97F4A7C15ull);
+		z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+		z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+		r->s[i] = z ^ (z >> 31);
+	}
+}
+
+///
+/// \brief Next random number
+///
+/// \param Generator
+/// \return 64 random bits
+///
+static inline uint64_t
+bnx_random_next(struct BnxRandom *r)
+{
+	const uint64_t result = bnx_random_rotl(r->s[1] * 5, 7) * 9;
+	const uint64_t t = r->s[1] << 17;
+
+	r->s[2] ^= r->s[0];
+	r->s[3] ^= r->s[1];
+	r->s[1] ^= r->s[2];
+	r->s[0] ^= r->s[3];
+	r->s[2] ^= t;
+	r->s[3] = bnx_random_rotl(r->s[3], 45);
+
+	return result;
+}
+
+///
+/// \brief Random number below a bound, without modulo bias worth noting
+/// 	for the small bounds of a binoxxo
+///
+/// \param Generator
+/// \param Bound, must not be zero
+/// \return Number in [0, bound)
+///
+static inline uint32_t
+bnx_random_below(struct BnxRandom *r, const uint32_t bound)
+{
+	return (uint32_t)(((bnx_random_next(r) >> 32) * bound) >> 32);
+}
+
+#endif // BINOXXO_RANDOM_H
@@ -0,0 +1,868 @@
+// 
+// binoxxo_sat.c
+// Copyright (C) 2014  Florian Tanner <florian.tanner@gmail.com>
+// 
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+// 
+
+
+
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "binoxxo_sat.h"
+#include "binoxxo_solver_ctx.h"
+
+///
+/// Flags of a clause, the literal block distance of a learnt clause is
+/// kept in the bits above them
+///
+#define BNX_SAT_LEARNT  1
+#define BNX_SAT_DELETED 2
+#define BNX_SAT_LBD_SHIFT 2
+
+///
+/// No clause, reason of decisions and given literals
+///
+#define BNX_SAT_NONE -1
+
+///
+/// Search was interrupted by a restart
+///
+#define BNX_SAT_RESTART -1
+
+static inline int
+bnx_sat_lit(const int dimacs)
+{
+	return dimacs > 0 ? 2 * (dimacs - 1) : 2 * (-dimacs - 1) + 1;
+}
+
+static inline int
+bnx_sat_lit_value(struct BnxSat const * const sat, const int lit)
+{
+	const int value = sat->value[lit >> 1];
+	return lit & 1 ? -value : value;
+}
+
+static void
+bnx_sat_heap_up(struct BnxSat *sat, int i)
+{
+	const int v = sat->heap[i];
+
+	while (i > 0) {
+		const int parent = (i - 1) / 2;
+		if (sat->activity[sat->heap[parent]] >= sat->activity[v]) {
+			break;
+		}
+		sat->heap[i] = sat->heap[parent];
+		sat->heap_pos[sat->heap[i]] = i;
+		i = parent;
+	}
+
+	sat->heap[i] = v;
+	sat->heap_pos[v] = i;
+}
+
+static void
+bnx_sat_heap_down(struct BnxSat *sat, int i)
+{
+	const int v = sat->heap[i];
+
+	for (;;) {
+		int child = 2 * i + 1;
+		if (child >= sat->heap_size) {
+			break;
+		}
+		if (child + 1 < sat->heap_size && sat->activity[sat->heap[child + 1]]
+		    > sat->activity[sat->heap[child]]) {
+			child++;
+		}
+		if (sat->activity[sat->heap[child]] <= sat->activity[v]) {
+			break;
+		}
+		sat->heap[i] = sat->heap[child];
+		sat->heap_pos[sat->heap[i]] = i;
+		i = child;
+	}
+
+	sat->heap[i] = v;
+	sat->heap_pos[v] = i;
+}
+
+static void
+bnx_sat_heap_insert(struct BnxSat *sat, const int v)
+{
+	sat->heap[sat->heap_size] = v;
+	bnx_sat_heap_up(sat, sat->heap_size++);
+}
+
+static int
+bnx_sat_heap_pop(struct BnxSat *sat)
+{
+	const int v = sat->heap[0];
+
+	sat->heap_pos[v] = -1;
+	if (--sat->heap_size > 0) {
+		sat->heap[0] = sat->heap[sat->heap_size];
+		bnx_sat_heap_down(sat, 0);
+	}
+
+	return v;
+}
+
+static void
+bnx_sat_bump(struct BnxSat *sat, const int v)
+{
+	sat->activity[v] += sat->increment;
+
+	// Scale all activities down before they overflow
+	if (sat->activity[v] > 1e100) {
+		int i;
+		for (i = 0; i < sat->vars; i++) {
+			sat->activity[i] *= 1e-100;
+		}
+		sat->increment *= 1e-100;
+	}
+
+	if (sat->heap_pos[v] >= 0) {
+		bnx_sat_heap_up(sat, sat->heap_pos[v]);
+	}
+}
+
+static int
+bnx_sat_watch(struct BnxSat *sat, const int lit, const int clause,
+              const int blocker)
+{
+	struct BnxSatWatches *w = &sat->watches[lit];
+
+	if (w->size == w->capacity) {
+		const size_t capacity = w->capacity ? 2 * w->capacity : 4;
+		struct BnxSatWatch *grown = realloc(w->watch,
+			capacity * sizeof(struct BnxSatWatch));
+		if (grown == NULL) {
+			return -ENOMEM;
+		}
+		w->watch    = grown;
+		w->capacity = capacity;
+	}
+
+	w->watch[w->size].clause  = clause;
+	w->watch[w->size].blocker = blocker;
+	w->size++;
+
+	return 0;
+}
+
+static int
+bnx_sat_attach(struct BnxSat *sat, const int clause)
+{
+	int const * const lit = sat->clause + clause + 2;
+
+	if (bnx_sat_watch(sat, lit[0], clause, lit[1]) != 0
+	    || bnx_sat_watch(sat, lit[1], clause, lit[0]) != 0) {
+		fprintf(stderr, "Could not allocate memory for watches\n");
+		return -ENOMEM;
+	}
+
+	return 0;
+}
+
+///
+/// \brief Store a clause of at least two literals
+///
+/// \param Solver
+/// \param Literals
+/// \param Number of literals
+/// \param Flags
+/// \return Clause reference, negative on error
+///
+static int
+bnx_sat_store(struct BnxSat *sat, int const * const lit, const int n,
+              const int flags)
+{
+	if (sat->length + n + 2 > sat->capacity) {
+		size_t capacity = sat->capacity ? 2 * sat->capacity : 4096;
+		while (capacity < sat->length + n + 2) {
+			capacity *= 2;
+		}
+		int *grown = realloc(sat->clause, capacity * sizeof(int));
+		if (grown == NULL) {
+			fprintf(stderr, "Could not allocate memory for clauses\n");
+			return -ENOMEM;
+		}
+		sat->clause   = grown;
+		sat->capacity = capacity;
+	}
+
+	const int clause = sat->length;
+	sat->clause[clause]     = n;
+	sat->clause[clause + 1] = flags;
+	memcpy(sat->clause + clause + 2, lit, n * sizeof(int));
+	sat->length += n + 2;
+
+	if (flags & BNX_SAT_LEARNT) {
+		if (sat->learnts == sat->learnt_capacity) {
+			const size_t capacity = sat->learnt_capacity
+				? 2 * sat->learnt_capacity : 1024;
+			int *grown = realloc(sat->learnt, capacity * sizeof(int));
+			if (grown == NULL) {
+				fprintf(stderr, "Could not allocate memory for clauses\n");
+				return -ENOMEM;
+			}
+			sat->learnt          = grown;
+			sat->learnt_capacity = capacity;
+		}
+		sat->learnt[sat->learnts++] = clause;
+	}
+
+	if (bnx_sat_attach(sat, clause) != 0) {
+		return -ENOMEM;
+	}
+
+	return clause;
+}
+
+static void
+bnx_sat_assign(struct BnxSat *sat, const int lit, const int reason)
+{
+	const int v = lit >> 1;
+
+	sat->value[v]  = lit & 1 ? -1 : 1;
+	sat->level[v]  = sat->levels;
+	sat->reason[v] = reason;
+	sat->trail[sat->trail_size++] = lit;
+}
+
+static void
+bnx_sat_backtrack(struct BnxSat *sat, const int level)
+{
+	if (sat->levels <= level) {
+		return;
+	}
+
+	int i;
+	for (i = sat->trail_size - 1; i >= sat->trail_lim[level]; i--) {
+		const int v = sat->trail[i] >> 1;
+
+		// Phase saving, the variable takes the same sign when decided again
+		sat->phase[v]  = sat->trail[i] & 1;
+		sat->value[v]  = 0;
+		sat->reason[v] = BNX_SAT_NONE;
+		if (sat->heap_pos[v] < 0) {
+			bnx_sat_heap_insert(sat, v);
+		}
+	}
+
+	sat->trail_size = sat->trail_lim[level];
+	sat->head       = sat->trail_size;
+	sat->levels     = level;
+}
+
+///
+/// \brief Assign all literals implied by unit clauses
+///
+/// \param Solver
+/// \return Reference of a clause with all literals false, or BNX_SAT_NONE
+///
+static int
+bnx_sat_propagate(struct BnxSat *sat)
+{
+	while (sat->head < sat->trail_size) {
+
+		const int false_lit = sat->trail[sat->head++] ^ 1;
+		struct BnxSatWatches *ws = &sat->watches[false_lit];
+		size_t i;
+		size_t j = 0;
+
+		for (i = 0; i < ws->size; i++) {
+
+			const struct BnxSatWatch w = ws->watch[i];
+			if (bnx_sat_lit_value(sat, w.blocker) > 0) {
+				ws->watch[j++] = w;
+				continue;
+			}
+
+			int *lit = sat->clause + w.clause + 2;
+			const int n = sat->clause[w.clause];
+
+			// Keep the false literal second
+			if (lit[0] == false_lit) {
+				lit[0] = lit[1];
+				lit[1] = false_lit;
+			}
+
+			const int first = lit[0];
+			if (first != w.blocker && bnx_sat_lit_value(sat, first) > 0) {
+				ws->watch[j].clause  = w.clause;
+				ws->watch[j].blocker = first;
+				j++;
+				continue;
+			}
+
+			// Watch another literal which is not false
+			int k;
+			for (k = 2; k < n; k++) {
+				if (bnx_sat_lit_value(sat, lit[k]) >= 0) {
+					break;
+				}
+			}
+
+			if (k < n) {
+				lit[1] = lit[k];
+				lit[k] = false_lit;
+				if (bnx_sat_watch(sat, lit[1], w.clause, first) == 0) {
+					continue;
+				}
+
+				// Without memory for the watcher the search ends
+				lit[k] = lit[1];
+				lit[1] = false_lit;
+				ws->watch[j++] = w;
+				sat->error = -ENOMEM;
+				continue;
+			}
+
+			ws->watch[j].clause  = w.clause;
+			ws->watch[j].blocker = first;
+			j++;
+
+			if (bnx_sat_lit_value(sat, first) < 0) {
+				// Conflict, keep the remaining watchers
+				while (++i < ws->size) {
+					ws->watch[j++] = ws->watch[i];
+				}
+				ws->size = j;
+				sat->head = sat->trail_size;
+				return w.clause;
+			}
+
+			if (bnx_sat_lit_value(sat, first) == 0) {
+				bnx_sat_assign(sat, first, w.clause);
+			}
+		}
+
+		ws->size = j;
+	}
+
+	return BNX_SAT_NONE;
+}
+
+///
+/// \brief Derive the first unique implication point clause of a conflict
+/// 	into the buffer, its asserting literal first and a literal of the
+/// 	backjump level second
+///
+/// \param Solver
+/// \param Conflicting clause
+/// \param Backjump level
+/// \param Literal block distance
+/// \return Number of literals
+///
+static int
+bnx_sat_analyze(struct BnxSat *sat, int clause, int *backjump, int *lbd)
+{
+	int *buffer = sat->buffer;
+	int paths = 0;
+	int lit = -1;
+	int index = sat->trail_size - 1;
+	int n = 1;
+	int i;
+
+	do {
+		int const * const c = sat->clause + clause + 2;
+		const int size = sat->clause[clause];
+
+		// The implied literal of a reason is its first
+		for (i = lit < 0 ? 0 : 1; i < size; i++) {
+			const int v = c[i] >> 1;
+			if (!sat->seen[v] && sat->level[v] > 0) {
+				bnx_sat_bump(sat, v);
+				sat->seen[v] = 1;
+				if (sat->level[v] >= sat->levels) {
+					paths++;
+				} else {
+					buffer[n++] = c[i];
+				}
+			}
+		}
+
+		while (!sat->seen[sat->trail[index] >> 1]) {
+			index--;
+		}
+		lit = sat->trail[index--];
+		clause = sat->reason[lit >> 1];
+		sat->seen[lit >> 1] = 0;
+		paths--;
+	} while (paths > 0);
+
+	buffer[0] = lit ^ 1;
+
+	// Drop literals implied by other literals of the clause, removed
+	// literals are marked by their complement
+	for (i = 1; i < n; i++) {
+		const int reason = sat->reason[buffer[i] >> 1];
+		if (reason == BNX_SAT_NONE) {
+			continue;
+		}
+
+		int const * const c = sat->clause + reason + 2;
+		const int size = sat->clause[reason];
+		int k;
+		for (k = 1; k < size; k++) {
+			const int v = c[k] >> 1;
+			if (!sat->seen[v] && sat->level[v] > 0) {
+				break;
+			}
+		}
+		if (k == size) {
+			buffer[i] = ~buffer[i];
+		}
+	}
+
+	int j = 1;
+	for (i = 1; i < n; i++) {
+		const int kept = buffer[i] >= 0;
+		const int l = kept ? buffer[i] : ~buffer[i];
+		sat->seen[l >> 1] = 0;
+		if (kept) {
+			buffer[j++] = l;
+		}
+	}
+	n = j;
+
+	// Second literal from the highest level below the conflict
+	*backjump = 0;
+	for (i = 1; i < n; i++) {
+		if (sat->level[buffer[i] >> 1] > *backjump) {
+			*backjump = sat->level[buffer[i] >> 1];
+			const int swap = buffer[1];
+			buffer[1] = buffer[i];
+			buffer[i] = swap;
+		}
+	}
+
+	*lbd = 0;
+	for (i = 0; i < n; i++) {
+		const int level = sat->level[buffer[i] >> 1];
+		if (sat->stamp[level] != sat->conflicts) {
+			sat->stamp[level] = sat->conflicts;
+			(*lbd)++;
+		}
+	}
+
+	return n;
+}
+
+///
+/// \brief Delete about half of the learnt clauses, those with the highest
+/// 	literal block distance, and clauses satisfied without decisions.
+/// 	Only at decision level 0, where no clause is the reason of a
+/// 	literal that conflict analysis would visit.
+///
+/// \param Solver
+/// \return Error
+///
+static int
+bnx_sat_reduce(struct BnxSat *sat)
+{
+	unsigned long count[BNX_MAX_SIZE + 1] = { 0 };
+	size_t i;
+	size_t keep = 0;
+	int limit;
+
+	for (i = 0; i < sat->learnts; i++) {
+		const int lbd = sat->clause[sat->learnt[i] + 1] >> BNX_SAT_LBD_SHIFT;
+		count[lbd < BNX_MAX_SIZE ? lbd : BNX_MAX_SIZE]++;
+	}
+
+	// Keep the clauses up to the median distance, and all glue clauses
+	for (limit = 0; limit < BNX_MAX_SIZE; limit++) {
+		keep += count[limit];
+		if (keep >= sat->learnts / 2) {
+			break;
+		}
+	}
+	if (limit < 2) {
+		limit = 2;
+	}
+
+	for (i = 0; i < sat->learnts; i++) {
+		const int lbd = sat->clause[sat->learnt[i] + 1] >> BNX_SAT_LBD_SHIFT;
+		if (lbd > limit) {
+			sat->clause[sat->learnt[i] + 1] |= BNX_SAT_DELETED;
+		}
+	}
+
+	for (i = 0; i < sat->trail_size; i++) {
+		sat->reason[sat->trail[i] >> 1] = BNX_SAT_NONE;
+	}
+
+	for (i = 0; i < 2 * sat->vars; i++) {
+		sat->watches[i].size = 0;
+	}
+
+	// Move the remaining clauses together and watch them again
+	size_t from = 0;
+	size_t to = 0;
+	sat->learnts = 0;
+	while (from < sat->length) {
+		const int n = sat->clause[from];
+		const int flags = sat->clause[from + 1];
+		int satisfied = false;
+		int k;
+
+		for (k = 0; k < n; k++) {
+			if (bnx_sat_lit_value(sat, sat->clause[from + 2 + k]) > 0) {
+				satisfied = true;
+				break;
+			}
+		}
+
+		if (!(flags & BNX_SAT_DELETED) && !satisfied) {
+			memmove(sat->clause + to, sat->clause + from,
+			        (n + 2) * sizeof(int));
+			if (flags & BNX_SAT_LEARNT) {
+				sat->learnt[sat->learnts++] = to;
+			}
+			if (bnx_sat_attach(sat, to) != 0) {
+				return -ENOMEM;
+			}
+			to += n + 2;
+		}
+		from += n + 2;
+	}
+	sat->length = to;
+
+	return 0;
+}
+
+///
+/// \brief Add a clause of internal literals at decision level 0
+///
+/// \param Solver
+/// \param Literals, may be reordered
+/// \param Number of literals
+/// \return False if the clauses became unsatisfiable
+///
+static int
+bnx_sat_add(struct BnxSat *sat, int *lit, const int n)
+{
+	int i;
+	int j = 0;
+	int satisfied = false;
+
+	bnx_sat_backtrack(sat, 0);
+	if (sat->unsat || sat->error) {
+		return false;
+	}
+
+	// Drop false and repeated literals, seen holds 1 + sign per variable
+	for (i = 0; i < n; i++) {
+		const int v = lit[i] >> 1;
+		const int value = bnx_sat_lit_value(sat, lit[i]);
+
+		if (value > 0 || sat->seen[v] == 2 - (lit[i] & 1)) {
+			satisfied = true;
+		} else if (value == 0 && !sat->seen[v]) {
+			sat->seen[v] = 1 + (lit[i] & 1);
+			lit[j++] = lit[i];
+		}
+	}
+	for (i = 0; i < j; i++) {
+		sat->seen[lit[i] >> 1] = 0;
+	}
+
+	if (satisfied) {
+		return true;
+	}
+
+	if (j == 0) {
+		sat->unsat = true;
+	} else if (j == 1) {
+		bnx_sat_assign(sat, lit[0], BNX_SAT_NONE);
+		if (bnx_sat_propagate(sat) != BNX_SAT_NONE) {
+			sat->unsat = true;
+		}
+	} else {
+		// Without memory for the clause the search can not go on, but the
+		// clauses are not unsatisfiable
+		const int clause = bnx_sat_store(sat, lit, j, 0);
+		if (clause < 0) {
+			sat->error = clause;
+		}
+	}
+
+	return !sat->unsat && !sat->error;
+}
+
+int
+bnx_sat_init(struct BnxSat *sat, const int vars)
+{
+	int v;
+
+	memset(sat, 0, sizeof(struct BnxSat));
+	sat->vars        = vars;
+	sat->increment   = 1.0;
+	sat->max_learnts = 2000;
+
+	sat->watches   = calloc(2 * vars, sizeof(struct BnxSatWatches));
+	sat->value     = calloc(vars, sizeof(signed char));
+	sat->phase     = malloc(vars * sizeof(signed char));
+	sat->level     = calloc(vars, sizeof(int));
+	sat->reason    = malloc(vars * sizeof(int));
+	sat->trail     = malloc(vars * sizeof(int));
+	sat->trail_lim = malloc((vars + 1) * sizeof(int));
+	sat->activity  = calloc(vars, sizeof(double));
+	sat->heap      = malloc(vars * sizeof(int));
+	sat->heap_pos  = malloc(vars * sizeof(int));
+	sat->seen      = calloc(vars, sizeof(char));
+	sat->stamp     = calloc(vars + 1, sizeof(unsigned long));
+	sat->buffer    = malloc((2 * vars + 1) * sizeof(int));
+
+	if (vars <= 0 || !sat->watches || !sat->value || !sat->phase
+	    || !sat->level || !sat->reason || !sat->trail || !sat->trail_lim
+	    || !sat->activity || !sat->heap || !sat->heap_pos || !sat->seen
+	    || !sat->stamp || !sat->buffer) {
+		fprintf(stderr, "Could not allocate memory for SAT solver\n");
+		bnx_sat_free(sat);
+		return -ENOMEM;
+	}
+
+	// Variables start false, for fields that is an o
+	for (v = 0; v < vars; v++) {
+		sat->phase[v]  = 1;
+		sat->reason[v] = BNX_SAT_NONE;
+		sat->heap_pos[v] = -1;
+		bnx_sat_heap_insert(sat, v);
+	}
+
+	return 0;
+}
+
+int
+bnx_sat_add_clause(struct BnxSat *sat, int const *lit, const size_t n)
+{
+	size_t i;
+	int j = 0;
+	int tautology = false;
+
+	// Repeated literals are dropped right away, the buffer holds one
+	// literal per variable
+	for (i = 0; i < n; i++) {
+		if (lit[i] == 0 || abs(lit[i]) > sat->vars) {
+			sat->unsat = true;
+			break;
+		}
+
+		const int l = bnx_sat_lit(lit[i]);
+		if (sat->seen[l >> 1] == 2 - (l & 1)) {
+			tautology = true;
+		} else if (!sat->seen[l >> 1]) {
+			sat->seen[l >> 1] = 1 + (l & 1);
+			sat->buffer[j++] = l;
+		}
+	}
+
+	for (i = 0; i < j; i++) {
+		sat->seen[sat->buffer[i] >> 1] = 0;
+	}
+
+	if (sat->unsat || tautology) {
+		return !sat->unsat && !sat->error;
+	}
+
+	return bnx_sat_add(sat, sat->buffer, j);
+}
+
+int
+bnx_sat_load(struct BnxSat *sat, struct BnxCnf const * const cnf)
+{
+	size_t start = 0;
+	size_t i;
+
+	for (i = 0; i < cnf->length; i++) {
+		if (cnf->lit[i] == 0) {
+			bnx_sat_add_clause(sat, cnf->lit + start, i - start);
+			start = i + 1;
+		}
+	}
+
+	return !sat->unsat && !sat->error;
+}
+
+void
+bnx_sat_prefer(struct BnxSat *sat, const int vars)
+{
+	int v;
+
+	for (v = 0; v < vars && v < sat->vars; v++) {
+		bnx_sat_bump(sat, v);
+	}
+}
+
+///
+/// \brief Search until a model, a contradiction or a number of conflicts
+///
+/// \param Solver
+/// \param Conflicts before a restart
+/// \return Result or BNX_SAT_RESTART
+///
+static int
+bnx_sat_search(struct BnxSat *sat, const unsigned long budget)
+{
+	unsigned long conflicts = 0;
+
+	for (;;) {
+		const int clause = bnx_sat_propagate(sat);
+
+		if (sat->error) {
+			return sat->error;
+		}
+
+		if (clause != BNX_SAT_NONE) {
+			sat->conflicts++;
+			conflicts++;
+
+			if (sat->levels == 0) {
+				sat->unsat = true;
+				return BNX_SAT_UNSAT;
+			}
+
+			int backjump;
+			int lbd;
+			const int n = bnx_sat_analyze(sat, clause, &backjump, &lbd);
+			bnx_sat_backtrack(sat, backjump);
+
+			if (n == 1) {
+				bnx_sat_assign(sat, sat->buffer[0], BNX_SAT_NONE);
+			} else {
+				const int learnt = bnx_sat_store(sat, sat->buffer, n,
+					BNX_SAT_LEARNT | lbd << BNX_SAT_LBD_SHIFT);
+				if (learnt < 0) {
+					sat->error = learnt;
+					return sat->error;
+				}
+				bnx_sat_assign(sat, sat->buffer[0], learnt);
+			}
+
+			// Recent conflicts weigh more
+			sat->increment /= 0.95;
+			continue;
+		}
+
+		if (conflicts >= budget) {
+			return BNX_SAT_RESTART;
+		}
+
+		// Most active open variable with its last sign
+		int v = -1;
+		while (sat->heap_size > 0) {
+			v = bnx_sat_heap_pop(sat);
+			if (sat->value[v] == 0) {
+				break;
+			}
+			v = -1;
+		}
+
+		if (v < 0) {
+			return BNX_SAT_SAT;
+		}
+
+		sat->decisions++;
+		sat->trail_lim[sat->levels++] = sat->trail_size;
+		bnx_sat_assign(sat, 2 * v + sat->phase[v], BNX_SAT_NONE);
+	}
+}
+
+int
+bnx_sat_solve(struct BnxSat *sat)
+{
+	unsigned long run;
+
+	bnx_sat_backtrack(sat, 0);
+	if (sat->error) {
+		return sat->error;
+	}
+	if (sat->unsat) {
+		return BNX_SAT_UNSAT;
+	}
+
+	for (run = 1; ; run++) {
+		const int result = bnx_sat_search(sat,
+			BNX_SAT_RESTART_CONFLICTS * bnx_luby(run));
+		if (result != BNX_SAT_RESTART) {
+			return result;
+		}
+
+		sat->restarts++;
+		bnx_sat_backtrack(sat, 0);
+
+		if (sat->learnts > sat->max_learnts) {
+			if (bnx_sat_reduce(sat) != 0) {
+				sat->error = -ENOMEM;
+				return sat->error;
+			}
+			sat->max_learnts += sat->max_learnts / 10;
+		}
+	}
+}
+
+int
+bnx_sat_value(struct BnxSat const * const sat, const int var)
+{
+	return sat->value[var - 1] > 0;
+}
+
+int
+bnx_sat_block(struct BnxSat *sat, const int vars)
+{
+	int v;
+
+	for (v = 0; v < vars; v++) {
+		sat->buffer[v] = 2 * v + (sat->value[v] > 0);
+	}
+
+	return bnx_sat_add(sat, sat->buffer, vars);
+}
+
+void
+bnx_sat_free(struct BnxSat *sat)
+{
+	int i;
+
+	if (sat->watches != NULL) {
+		for (i = 0; i < 2 * sat->vars; i++) {
+			free(sat->watches[i].watch);
+		}
+	}
+
+	free(sat->clause);
+	free(sat->learnt);
+	free(sat->watches);
+	free(sat->value);
+	free(sat->phase);
+	free(sat->level);
+	free(sat->reason);
+	free(sat->trail);
+	free(sat->trail_lim);
+	free(sat->activity);
+	free(sat->heap);
+	free(sat->heap_pos);
+	free(sat->seen);
+	free(sat->stamp);
+	free(sat->buffer);
+	memset(sat, 0, sizeof(struct BnxSat));
+}
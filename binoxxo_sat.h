@@ -0,0 +1,184 @@
+// 
+// binoxxo_sat.h
+// Copyright (C) 2014  Florian Tanner <florian.tanner@gmail.com>
+// 
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+// 
+
+
+
+
+#ifndef BINOXXO_SAT_H
+#define BINOXXO_SAT_H
+
+#include <stddef.h>
+
+#include "binoxxo_cnf.h"
+
+///
+/// Conflicts of the shortest run between two restarts, the run i lasts
+/// this times the i-th element of the Luby sequence
+///
+#define BNX_SAT_RESTART_CONFLICTS 100
+
+///
+/// Result of a search
+///
+enum BnxSatResult {
+	BNX_SAT_UNSAT = 0,
+	BNX_SAT_SAT   = 1,
+};
+
+///
+/// Watcher of a clause, the clause is visited when the watched literal
+/// becomes false unless the blocker is true
+///
+struct BnxSatWatch {
+	int clause;
+	int blocker;
+};
+
+///
+/// Watchers of one literal
+///
+struct BnxSatWatches {
+	struct BnxSatWatch *watch;
+	size_t size;
+	size_t capacity;
+};
+
+///
+/// Conflict-driven clause-learning SAT solver
+///
+/// 	Literal 2 * v + 1 is the negation of literal 2 * v of variable v.
+/// 	Clauses are stored one after another in one array, a clause is
+/// 	referenced by the index of its header: the number of literals and
+/// 	the flags, followed by the literals. The first two literals of a
+/// 	clause are watched.
+///
+struct BnxSat {
+	int vars;
+	int *clause;					// Clause headers and literals
+	size_t length;
+	size_t capacity;
+	int *learnt;					// References of learnt clauses
+	size_t learnts;
+	size_t learnt_capacity;
+	size_t max_learnts;				// Learnt clauses kept at a restart
+	struct BnxSatWatches *watches;	// Indexed by literal
+	signed char *value;				// Per variable, 1 true, -1 false, 0 open
+	signed char *phase;				// Last sign of a variable
+	int *level;						// Decision level of an assignment
+	int *reason;					// Clause which implied an assignment
+	int *trail;						// Assigned literals in order
+	int trail_size;
+	int *trail_lim;					// Trail size at every decision level
+	int levels;
+	int head;						// Next trail literal to propagate
+	double *activity;				// Per variable
+	double increment;
+	int *heap;						// Open variables, most active first
+	int *heap_pos;					// Position in the heap or -1
+	int heap_size;
+	char *seen;						// Scratch flags of conflict analysis
+	unsigned long *stamp;			// Scratch marks per decision level
+	int *buffer;					// Learnt clause under construction
+	int unsat;						// Clauses contradict without decisions
+	int error;						// Memory ran out, no search is possible
+	unsigned long decisions;
+	unsigned long conflicts;
+	unsigned long restarts;
+};
+
+///
+/// \brief Initialize a solver without clauses
+///
+/// \param Solver
+/// \param Number of variables
+/// \return Error
+///
+int
+bnx_sat_init(struct BnxSat *, const int);
+
+///
+/// \brief Add a clause, only between searches
+///
+/// \param Solver
+/// \param DIMACS literals of the clause, without the final 0
+/// \param Number of literals
+/// \return False if the clauses became unsatisfiable or memory ran out
+///
+int
+bnx_sat_add_clause(struct BnxSat *, int const *, const size_t);
+
+///
+/// \brief Add all clauses of a formula
+///
+/// \param Solver
+/// \param Formula
+/// \return False if the clauses became unsatisfiable or memory ran out
+///
+int
+bnx_sat_load(struct BnxSat *, struct BnxCnf const * const);
+
+///
+/// \brief Decide the first variables before all others, until conflicts
+/// 	make other variables more active
+///
+/// \param Solver
+/// \param Number of variables
+///
+void
+bnx_sat_prefer(struct BnxSat *, const int);
+
+///
+/// \brief Search an assignment which satisfies all clauses
+///
+/// \param Solver
+/// \return Result, on BNX_SAT_SAT the model is read with bnx_sat_value,
+/// 	negative on error
+///
+int
+bnx_sat_solve(struct BnxSat *);
+
+///
+/// \brief Value of a variable in the model of the last search
+///
+/// \param Solver
+/// \param DIMACS variable
+/// \return True or false
+///
+int
+bnx_sat_value(struct BnxSat const * const, const int);
+
+///
+/// \brief Exclude the model of the last search by a clause over its first
+/// 	variables, so the next search finds another assignment of them
+///
+/// \param Solver
+/// \param Number of variables
+/// \return False if no other assignment is left or memory ran out
+///
+int
+bnx_sat_block(struct BnxSat *, const int);
+
+///
+/// \brief Release a solver
+///
+/// \param Solver
+///
+void
+bnx_sat_free(struct BnxSat *);
+
+#endif // BINOXXO_SAT_H
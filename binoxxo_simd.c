@@ -0,0 +1,259 @@
+// 
+// binoxxo_simd.c
+// Copyright (C) 2014  Florian Tanner <florian.tanner@gmail.com>
+// 
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+// 
+
+
+
+#include <stdatomic.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define BNX_SIMD_X86
+#endif
+
+#include "binoxxo_simd.h"
+
+///
+/// Kernel picked by the first call of bnx_check_lines
+///
+static _Atomic(BnxCheckFnc) bnx_check_fnc = NULL;
+
+static void
+bnx_check_scalar(struct BnxBoard const * const board, const int dir,
+                 struct BnxCheck *check)
+{
+	const int half = board->size / 2;
+	int i;
+
+	memset(check, 0, sizeof(struct BnxCheck));
+
+	for (i = 0; i < board->size; i++) {
+		const BnxMask o = board->o[dir][i];
+		const BnxMask x = board->x[dir][i];
+		const BnxMask bit = (BnxMask)1 << i;
+
+		if ((o | x) != board->full) {
+			check->fill |= bit;
+		}
+		if (o & x) {
+			check->conflict |= bit;
+		}
+		if ((o & (o >> 1) & (o >> 2)) | (x & (x >> 1) & (x >> 2))) {
+			check->follow |= bit;
+		}
+		if (board->count_o[dir][i] > half || board->count_x[dir][i] > half) {
+			check->balance |= bit;
+		}
+	}
+}
+
+#ifdef BNX_SIMD_X86
+
+__attribute__((target("sse4.2")))
+static void
+bnx_check_sse42(struct BnxBoard const * const board, const int dir,
+                struct BnxCheck *check)
+{
+	const __m128i full = _mm_set1_epi64x(board->full);
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i half = _mm_set1_epi8(board->size / 2);
+	const BnxMask lines = board->full;
+	BnxMask filled = 0;
+	BnxMask clean = 0;
+	BnxMask spaced = 0;
+	BnxMask balanced = 0;
+	int i;
+
+	// Two lines per step, lines past the size are zero
+	for (i = 0; i < board->size; i += 2) {
+		const __m128i o = _mm_loadu_si128((const __m128i *)&board->o[dir][i]);
+		const __m128i x = _mm_loadu_si128((const __m128i *)&board->x[dir][i]);
+		const __m128i triple = _mm_or_si128(
+			_mm_and_si128(o, _mm_and_si128(_mm_srli_epi64(o, 1),
+			                               _mm_srli_epi64(o, 2))),
+			_mm_and_si128(x, _mm_and_si128(_mm_srli_epi64(x, 1),
+			                               _mm_srli_epi64(x, 2))));
+
+		filled |= (BnxMask)_mm_movemask_pd(_mm_castsi128_pd(
+			_mm_cmpeq_epi64(_mm_or_si128(o, x), full))) << i;
+		clean |= (BnxMask)_mm_movemask_pd(_mm_castsi128_pd(
+			_mm_cmpeq_epi64(_mm_and_si128(o, x), zero))) << i;
+		spaced |= (BnxMask)_mm_movemask_pd(_mm_castsi128_pd(
+			_mm_cmpeq_epi64(triple, zero))) << i;
+	}
+
+	// Counts are 8 bit, sixteen lines per step
+	for (i = 0; i < board->size; i += 16) {
+		const __m128i o = _mm_loadu_si128(
+			(const __m128i *)&board->count_o[dir][i]);
+		const __m128i x = _mm_loadu_si128(
+			(const __m128i *)&board->count_x[dir][i]);
+
+		balanced |= (BnxMask)(unsigned int)_mm_movemask_epi8(_mm_or_si128(
+			_mm_cmpgt_epi8(o, half), _mm_cmpgt_epi8(x, half))) << i;
+	}
+
+	check->fill     = ~filled & lines;
+	check->conflict = ~clean & lines;
+	check->follow   = ~spaced & lines;
+	check->balance  = balanced & lines;
+}
+
+__attribute__((target("avx2")))
+static void
+bnx_check_avx2(struct BnxBoard const * const board, const int dir,
+               struct BnxCheck *check)
+{
+	const __m256i full = _mm256_set1_epi64x(board->full);
+	const __m256i zero = _mm256_setzero_si256();
+	const __m256i half = _mm256_set1_epi8(board->size / 2);
+	const BnxMask lines = board->full;
+	BnxMask filled = 0;
+	BnxMask clean = 0;
+	BnxMask spaced = 0;
+	BnxMask balanced = 0;
+	int i;
+
+	// Four lines per step, lines past the size are zero
+	for (i = 0; i < board->size; i += 4) {
+		const __m256i o = _mm256_loadu_si256(
+			(const __m256i *)&board->o[dir][i]);
+		const __m256i x = _mm256_loadu_si256(
+			(const __m256i *)&board->x[dir][i]);
+		const __m256i triple = _mm256_or_si256(
+			_mm256_and_si256(o, _mm256_and_si256(_mm256_srli_epi64(o, 1),
+			                                     _mm256_srli_epi64(o, 2))),
+			_mm256_and_si256(x, _mm256_and_si256(_mm256_srli_epi64(x, 1),
+			                                     _mm256_srli_epi64(x, 2))));
+
+		filled |= (BnxMask)_mm256_movemask_pd(_mm256_castsi256_pd(
+			_mm256_cmpeq_epi64(_mm256_or_si256(o, x), full))) << i;
+		clean |= (BnxMask)_mm256_movemask_pd(_mm256_castsi256_pd(
+			_mm256_cmpeq_epi64(_mm256_and_si256(o, x), zero))) << i;
+		spaced |= (BnxMask)_mm256_movemask_pd(_mm256_castsi256_pd(
+			_mm256_cmpeq_epi64(triple, zero))) << i;
+	}
+
+	// Counts are 8 bit, 32 lines per step
+	for (i = 0; i < board->size; i += 32) {
+		const __m256i o = _mm256_loadu_si256(
+			(const __m256i *)&board->count_o[dir][i]);
+		const __m256i x = _mm256_loadu_si256(
+			(const __m256i *)&board->count_x[dir][i]);
+
+		balanced |= (BnxMask)(unsigned int)_mm256_movemask_epi8(
+			_mm256_or_si256(_mm256_cmpgt_epi8(o, half),
+			                _mm256_cmpgt_epi8(x, half))) << i;
+	}
+
+	check->fill     = ~filled & lines;
+	check->conflict = ~clean & lines;
+	check->follow   = ~spaced & lines;
+	check->balance  = balanced & lines;
+}
+
+static int
+bnx_cpu_avx2(void)
+{
+	__builtin_cpu_init();
+	return __builtin_cpu_supports("avx2");
+}
+
+static int
+bnx_cpu_sse42(void)
+{
+	__builtin_cpu_init();
+	return __builtin_cpu_supports("sse4.2");
+}
+
+#endif // BNX_SIMD_X86
+
+///
+/// All kernels, the fastest first
+///
+static const struct BnxCheckKernel bnx_check_table[] = {
+#ifdef BNX_SIMD_X86
+	{ "avx2",   &bnx_check_avx2,   &bnx_cpu_avx2 },
+	{ "sse4.2", &bnx_check_sse42,  &bnx_cpu_sse42 },
+#endif
+	{ "scalar", &bnx_check_scalar, NULL },
+};
+
+#define BNX_CHECK_TABLE_SIZE \
+	(sizeof(bnx_check_table) / sizeof(bnx_check_table[0]))
+
+struct BnxCheckKernel const *
+bnx_check_kernel_get(const int index)
+{
+	int found = 0;
+	size_t i;
+
+	for (i = 0; i < BNX_CHECK_TABLE_SIZE; i++) {
+		struct BnxCheckKernel const *kernel = &bnx_check_table[i];
+		if (kernel->supported == NULL || kernel->supported()) {
+			if (found++ == index) {
+				return kernel;
+			}
+		}
+	}
+
+	return NULL;
+}
+
+static BnxCheckFnc
+bnx_check_select(void)
+{
+	// The scalar kernel runs everywhere
+	return bnx_check_kernel_get(0)->check;
+}
+
+static BnxCheckFnc
+bnx_check_get(void)
+{
+	BnxCheckFnc fnc = atomic_load_explicit(&bnx_check_fnc,
+	                                       memory_order_relaxed);
+
+	// Threads racing here all store the same kernel
+	if (fnc == NULL) {
+		fnc = bnx_check_select();
+		atomic_store_explicit(&bnx_check_fnc, fnc, memory_order_relaxed);
+	}
+
+	return fnc;
+}
+
+void
+bnx_check_lines(struct BnxBoard const * const board, const int dir,
+                struct BnxCheck *check)
+{
+	bnx_check_get()(board, dir, check);
+}
+
+const char *
+bnx_check_kernel(void)
+{
+	const BnxCheckFnc fnc = bnx_check_get();
+	size_t i;
+
+	for (i = 0; i < BNX_CHECK_TABLE_SIZE; i++) {
+		if (bnx_check_table[i].check == fnc) {
+			return bnx_check_table[i].name;
+		}
+	}
+
+	return "unknown";
+}
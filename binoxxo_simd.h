@@ -0,0 +1,83 @@
+// 
+// binoxxo_simd.h
+// Copyright (C) 2014  Florian Tanner <florian.tanner@gmail.com>
+// 
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+// 
+
+
+
+#ifndef BINOXXO_SIMD_H
+#define BINOXXO_SIMD_H
+
+#include "binoxxo_board.h"
+
+///
+/// Lines of one direction breaking a rule, bit i stands for line i
+///
+struct BnxCheck {
+	BnxMask fill;					// Lines with empty fields
+	BnxMask conflict;
+	BnxMask follow;
+	BnxMask balance;
+};
+
+///
+/// Function pointer for a kernel checking all lines of one direction
+///
+typedef void
+(*BnxCheckFnc)(struct BnxBoard const * const, const int, struct BnxCheck *);
+
+///
+/// Kernel of bnx_check_lines with its name
+///
+struct BnxCheckKernel {
+	const char *name;
+	BnxCheckFnc check;
+	int (*supported)(void);			// NULL if it runs everywhere
+};
+
+///
+/// \brief Check the fill, conflict, triple and balance rules of all lines
+/// 	of one direction at once. Columns are stored transposed in the
+/// 	board, so rows and columns run through the same kernel. The kernel
+/// 	is picked on the first call, AVX2 or SSE4.2 if the processor
+/// 	supports it and plain 64 bit operations otherwise.
+///
+/// \param Board
+/// \param Direction
+/// \param Result
+///
+void
+bnx_check_lines(struct BnxBoard const * const, const int, struct BnxCheck *);
+
+///
+/// \brief Name of the kernel used by bnx_check_lines
+///
+/// \return "avx2", "sse4.2" or "scalar"
+///
+const char *
+bnx_check_kernel(void);
+
+///
+/// \brief Get a kernel which runs on this processor, so tests can run
+/// 	every kernel and not only the one picked by bnx_check_lines
+///
+/// \param Index, 0 is the kernel picked by bnx_check_lines
+/// \return Kernel, NULL past the last one
+///
+struct BnxCheckKernel const *
+bnx_check_kernel_get(const int);
+
+#endif // BINOXXO_SIMD_H
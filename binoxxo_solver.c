@@ -17,27 +17,10 @@
 // 
 
 
+#include "binoxxo_cache.h"
+#include "binoxxo_sat.h"
 #include "binoxxo_solver.h"
 
-static int
-bnx_invert_value(const int field)
-{
-	return BNX_INVERT_FIELD * field;
-}
-
-static int
-bnx_is_field_empty(struct BnxLine const * const line, const int index)
-{
-	return *line->data[index] == BNX_FIELD_EMPTY;
-}
-
-static int
-bnx_is_field_eq_not_empty(struct BnxLine const * const line,
-                          const int a, const int b)
-{
-	return *line->data[a] == *line->data[b] && !bnx_is_field_empty(line, a);
-}
-
 struct BnxSolution *
 bnx_solution_alloc(void)
 {
@@ -53,6 +36,23 @@ bnx_solution_alloc(void)
 	return s;
 }
 
+static struct BnxSolution *
+bnx_solution_alloc_board(const size_t size)
+{
+	// The binoxxo follows the list node in the same block
+	struct BnxSolution *s = malloc(sizeof(struct BnxSolution)
+		+ bnx_alloc_size(size));
+	if (!s) {
+		fprintf(stderr, "Could not allocate memory for solution list\n");
+		return NULL;
+	}
+
+	s->data = bnx_init(s + 1, size);
+	s->next = NULL;
+
+	return s;
+}
+
 void
 bnx_solution_free(struct BnxSolution *s)
 {
@@ -60,7 +60,7 @@ bnx_solution_free(struct BnxSolution *s)
 	struct BnxSolution *last = s;
 	
 	while (cur) {
-		if (cur->data) {
+		if (cur->data && cur->data != (struct Bnx *)(cur + 1)) {
 			bnx_free(cur->data);
 		}
 		last = cur;
@@ -69,170 +69,285 @@ bnx_solution_free(struct BnxSolution *s)
 	}
 }
 
-static int
-bnx_scanner_double(struct BnxLine const *line)
+int
+bnx_visitor_list(struct Bnx const *b, void *data)
 {
-	const size_t size = line->size - 1;
-	int i;
-	int inverted;
-	int modified = false;
-	int empty_prev;
-	int empty_next = bnx_is_field_empty(line, 2);
-	int equal_not_empty = bnx_is_field_eq_not_empty(line, 0, 1);
-
-	// Scan |xx_
-	if (equal_not_empty && empty_next) {
-		*line->data[2] = bnx_invert_value(*line->data[0]);
-		modified = true;
+	struct BnxSolution **list = data;
+
+	struct BnxSolution *solution = bnx_solution_alloc_board(b->size);
+	if (solution == NULL) {
+		return false;
 	}
 
-	// Scan _xx_
-	for (i = 1; i < size - 1; i++) {
-		
-		equal_not_empty = bnx_is_field_eq_not_empty(line, i, i + 1);
-
-		if (equal_not_empty) {
-		
-			empty_prev = bnx_is_field_empty(line, i - 1);
-			empty_next = bnx_is_field_empty(line, i + 2);
-			inverted = bnx_invert_value(*line->data[i]);
-		
-			if (empty_prev) {
-				*line->data[i - 1] = inverted;
-				modified = true;
-			}
-			if (empty_next) {
-				*line->data[i + 2] = inverted;
-				modified = true;
-			}		
-		}
+	bnx_copy(solution->data, b);
+	solution->next = *list;
+	*list = solution;
+
+	return true;
+}
+
+void
+bnx_collector_init(struct BnxCollector *c, const int sol_mode)
+{
+	pthread_mutex_init(&c->lock, NULL);
+	c->solution = NULL;
+	c->visitor  = &bnx_visitor_list;
+	c->data     = &c->solution;
+	c->visited  = NULL;
+	c->witness  = NULL;
+	c->count    = 0;
+	atomic_init(&c->free_solutions, sol_mode);
+}
+
+void
+bnx_collector_init_visit(struct BnxCollector *c, BnxVisitorFnc visitor,
+                         void *data)
+{
+	bnx_collector_init(c, BNX_SOLUTION_MODE_ALL);
+	c->visitor = visitor;
+	c->data    = data;
+}
+
+void
+bnx_collector_init_count(struct BnxCollector *c, const int limit,
+                         struct Bnx *witness)
+{
+	bnx_collector_init(c, limit);
+	c->visitor = NULL;
+	c->data    = NULL;
+	c->witness = witness;
+}
+
+int
+bnx_collector_add(struct BnxCollector *c, struct BnxBoard const * const board)
+{
+	int added = false;
+
+	pthread_mutex_lock(&c->lock);
+
+	int free_solutions = atomic_load(&c->free_solutions);
+	if (free_solutions == 0) {
+		pthread_mutex_unlock(&c->lock);
+		return false;
 	}
 
-	equal_not_empty = bnx_is_field_eq_not_empty(line, size, size - 1);
-	empty_prev = bnx_is_field_empty(line, size - 2);
+	if (c->count == 0 && c->witness != NULL) {
+		bnx_board_unpack(c->witness, board);
+	}
 
-	// Scan _xx|
-	if (equal_not_empty && empty_prev) {
-		*line->data[size - 2] = bnx_invert_value(*line->data[size]);
-		modified = true;
+	// The visited binoxxo is reused for all solutions
+	if (c->visitor != NULL && c->visited == NULL) {
+		c->visited = bnx_alloc(board->size);
 	}
-	
-	return modified;
+
+	if (c->visitor == NULL) {
+		added = true;
+	} else if (c->visited != NULL) {
+		bnx_board_unpack(c->visited, board);
+		added = true;
+		if (!c->visitor(c->visited, c->data)) {
+			free_solutions = 1;
+		}
+	}
+
+	if (added) {
+		c->count++;
+		if (free_solutions != BNX_SOLUTION_MODE_ALL) {
+			atomic_store(&c->free_solutions, free_solutions - 1);
+		}
+	}
+
+	pthread_mutex_unlock(&c->lock);
+
+	return added;
+}
+
+int
+bnx_collector_done(struct BnxCollector *c)
+{
+	return atomic_load(&c->free_solutions) == 0;
+}
+
+struct BnxSolution *
+bnx_collector_destroy(struct BnxCollector *c)
+{
+	struct BnxSolution *solutions = c->solution;
+
+	c->solution = NULL;
+	bnx_free(c->visited);
+	c->visited = NULL;
+	pthread_mutex_destroy(&c->lock);
+
+	return solutions;
 }
 
 static int
-bnx_scanner_triple(struct BnxLine const *line)
+bnx_scanner_double(struct BnxBits *line)
 {
-	const size_t size = line->size - 2;
-	int i;
-	int modified = false;
-	int equal_not_empty;
-	int empty;
-	
-	for (i = 0; i < size; i++) {
-		
-		equal_not_empty = bnx_is_field_eq_not_empty(line, i, i + 2);
-		empty = bnx_is_field_empty(line, i + 1);
-		
-		if (equal_not_empty && empty) {
-			*line->data[i + 1] = bnx_invert_value(*line->data[i]);
-			modified = true;
-		}
-	}
-	
-	return modified;
+	const BnxMask empty = line->full & ~(line->o | line->x);
+	const BnxMask pair_o = line->o & (line->o >> 1);
+	const BnxMask pair_x = line->x & (line->x >> 1);
+
+	// Scan _xx_, bit i of a pair covers fields i and i + 1
+	const BnxMask add_o = ((pair_x >> 1) | (pair_x << 2)) & empty;
+	const BnxMask add_x = ((pair_o >> 1) | (pair_o << 2)) & empty;
+
+	line->o |= add_o;
+	line->x |= add_x;
+
+	return (add_o | add_x) != 0;
 }
 
 static int
-bnx_get_filler(struct BnxLine const * const line)
+bnx_scanner_triple(struct BnxBits *line)
 {
-	const size_t size = line->size;
-	int i;
-	int sum_o = 0;
-	int sum_x = 0;
-	int half = line->size / 2;
-
-	for (i = 0; i < size && sum_o < half && sum_x < half; i++) {
-		switch (*line->data[i]) {
-		
-			case BNX_FIELD_O:
-				sum_o++;
-				break;
-			
-			case BNX_FIELD_X:
-				sum_x++;
-				break;
-		}
-	}
-	
-	if (sum_o == half && sum_x < half) {
-		return BNX_FIELD_X;
-	} else if (sum_x == half && sum_o < half) {
-		return BNX_FIELD_O;
-	}
-	return BNX_FIELD_EMPTY;
+	const BnxMask empty = line->full & ~(line->o | line->x);
+	const BnxMask gap_o = line->o & (line->o >> 2);
+	const BnxMask gap_x = line->x & (line->x >> 2);
+
+	// Scan x_x, bit i of a gap covers fields i and i + 2
+	const BnxMask add_o = (gap_x << 1) & empty;
+	const BnxMask add_x = (gap_o << 1) & empty;
+
+	line->o |= add_o;
+	line->x |= add_x;
+
+	return (add_o | add_x) != 0;
 }
 
 static int
-bnx_fill_empty(struct BnxLine const *line, const int filler)
+bnx_scanner_count(struct BnxBits *line)
 {
-	const size_t size = line->size;
-	int i;
-	int modified = false;
-	
-	for (i = 0; i < size; i++) {
-		if (bnx_is_field_empty(line, i)) {
-			*line->data[i] = filler;
-			modified = true;
-		}
+	const int half = line->size / 2;
+	const BnxMask empty = line->full & ~(line->o | line->x);
+
+	if (empty == 0) {
+		return false;
 	}
-	
-	return modified;
+
+	if (bnx_mask_count(line->o) == half) {
+		line->x |= empty;
+		return true;
+	} else if (bnx_mask_count(line->x) == half) {
+		line->o |= empty;
+		return true;
+	}
+
+	return false;
 }
 
-static int
-bnx_scanner_count(struct BnxLine const * const line)
+///
+/// Rules applied to every queued line, in the order of enum BnxRule
+///
+static const BnxBitsScannerFnc bnx_scanners[] = {
+	&bnx_scanner_double,
+	&bnx_scanner_triple,
+	&bnx_scanner_count,
+};
+
+static inline __attribute__((always_inline)) int
+bnx_solve_line(struct BnxBoard const * const board, const int dir,
+               const int index, struct BnxBits *line, struct BnxStats *stats)
 {
+	const size_t count = sizeof(bnx_scanners) / sizeof(bnx_scanners[0]);
+	int i;
 	int modified = false;
-	int filler = bnx_get_filler(line);
-	
-	if (filler != BNX_FIELD_EMPTY) {
-		modified = bnx_fill_empty(line, filler);
+	int changed = true;
+
+	while (changed) {
+		changed = false;
+		for (i = 0; i < count; i++) {
+#ifdef BNX_STATS
+			const int filled = bnx_mask_count(line->o | line->x);
+#endif
+			if (bnx_scanners[i](line)) {
+				changed = true;
+				BNX_STATS_ADD(stats, forced[i],
+				              bnx_mask_count(line->o | line->x) - filled);
+			}
+		}
+
+		// Costly, only run once the cheap rules are exhausted
+		if (!changed) {
+#ifdef BNX_STATS
+			const int filled = bnx_mask_count(line->o | line->x);
+#endif
+			changed = bnx_lines_scan(board, dir, index, line);
+			BNX_STATS_ADD(stats, forced[BNX_RULE_LINES],
+			              bnx_mask_count(line->o | line->x) - filled);
+		}
+		modified |= changed;
 	}
 
 	return modified;
 }
 
-static int
-bnx_solve_trivial(struct Bnx const *progress)
+///
+/// \brief Propagate the queued lines. With a size known at compile time the
+/// 	rules work on constant bounds and masks.
+///
+static inline __attribute__((always_inline)) int
+bnx_solve_trivial(struct BnxBoard *progress, struct BnxStats *stats,
+                  const size_t size)
 {
-	int error = bnx_validate(progress);
-	int modified = true;
+	int dir;
+	int index;
+	struct BnxBits line;
 
-	while (error != BNX_CORRECT && modified) {
-	
-		modified = bnx_scan(progress, &bnx_scanner_double, BNX_SCAN_H)
-			| bnx_scan(progress, &bnx_scanner_double, BNX_SCAN_V)
-			| bnx_scan(progress, &bnx_scanner_triple, BNX_SCAN_H)
-			| bnx_scan(progress, &bnx_scanner_triple, BNX_SCAN_V)
-			| bnx_scan(progress, &bnx_scanner_count, BNX_SCAN_H)
-			| bnx_scan(progress, &bnx_scanner_count, BNX_SCAN_V);
-
-		error = bnx_validate(progress);
+	BNX_STATS_START(propagation);
+
+	// Only lines with new fields are queued, a guess queues two lines
+	while (bnx_board_pop(progress, &dir, &index)) {
+
+		bnx_board_get_line(progress, dir, index, &line);
+		if (size > 0) {
+			line.size = size;
+			line.full = ((BnxMask)1 << size) - 1;
+		}
+
+		if (bnx_solve_line(progress, dir, index, &line, stats)) {
+			bnx_board_put_line(progress, dir, index, &line);
+
+			if (bnx_bits_validate(&line) & ~BNX_ERR_FILL) {
+				break;
+			}
+		}
 	}
 
+	BNX_STATS_STOP(stats, propagation, propagation);
+	BNX_STATS_START(validation);
+
+	const int error = bnx_board_validate_dirty(progress);
+
+	BNX_STATS_STOP(stats, validation, validation);
+	BNX_STATS_ADD(stats, validations, 1);
+
 	return error;
 }
 
-static int
-bnx_solve_rec(struct BnxSolverCtx *ctx)
+///
+/// Function pointer for a search of one size, used for the recursion
+///
+typedef int (*BnxSolveRecFnc)(struct BnxSolverCtx *);
+
+///
+/// \brief Search a board, size is 0 for the generic search
+///
+static inline __attribute__((always_inline)) int
+bnx_solve_rec_sized(struct BnxSolverCtx *ctx, const size_t size,
+                    BnxSolveRecFnc self)
 {
+	struct BnxBoard *board = ctx->board;
+	int error = bnx_solve_trivial(board, &ctx->stats, size);
 
-	if (ctx->current == NULL) {
-		return BNX_ERR_UNKNOWN;
-	}
+	ctx->stats.nodes++;
 
-	int error = bnx_solve_trivial(ctx->current);
+	// Give up this run once its budget is used up
+	if (ctx->budget > 0 && --ctx->budget == 0) {
+		ctx->aborted = true;
+	}
+	BNX_STATS_ADD(&ctx->stats, depth, 1);
+	BNX_STATS_MAX(&ctx->stats, max_depth, ctx->stats.depth);
 	
 	// Shortcut
 	if (error & ~BNX_ERR_FILL) {
@@ -241,55 +356,324 @@ bnx_solve_rec(struct BnxSolverCtx *ctx)
 	
 	if (error & BNX_ERR_FILL) {
 
-		bnx_update_guess_map(ctx->guess_map, ctx->current);
+		struct BnxGuess guess;
+
+		BNX_STATS_START(guessing);
+		const int guessed = ctx->guesser(ctx, &guess);
+		BNX_STATS_STOP(&ctx->stats, guessing, guessing);
 
-		struct Bnx **child = ctx->guesser(ctx);
+		if (!guessed) {
+			goto bnx_solve_rec_shortcut;
+		}
+
+		// Hand the second branch to other threads if they want work
+		int branches = 2;
+		if (ctx->spawn != NULL && ctx->spawn(ctx, guess.row, guess.col,
+		                                     guess.field * BNX_INVERT_FIELD)) {
+			branches = 1;
+		}
+
+		const size_t mark = bnx_board_mark(board);
+		int field = guess.field;
 		int i;
-		for (i = 0; i < 2; i++) {
-			ctx->current = child[i];
-			if (bnx_solve_rec(ctx) != BNX_CORRECT) {
-				bnx_free(child[i]);
+		for (i = 0; i < branches && !ctx->aborted
+		            && !bnx_collector_done(ctx->collector); i++) {
+			bnx_board_set(board, guess.row, guess.col, field);
+			self(ctx);
+			bnx_board_undo(board, mark);
+			BNX_STATS_ADD(&ctx->stats, backtracks, 1);
+			field *= BNX_INVERT_FIELD;
+		}
+
+	} else if (error == BNX_CORRECT) {
+		bnx_collector_add(ctx->collector, board);
+	} 
+
+bnx_solve_rec_shortcut:
+	BNX_STATS_ADD(&ctx->stats, depth, -1);
+	return error;
+}
+
+static int
+bnx_solve_rec(struct BnxSolverCtx *ctx)
+{
+	return bnx_solve_rec_sized(ctx, 0, &bnx_solve_rec);
+}
+
+///
+/// \brief Instantiate the search for one size
+///
+#define BNX_SOLVER_SIZE(n) \
+static int \
+bnx_solve_rec_##n(struct BnxSolverCtx *ctx) \
+{ \
+	return bnx_solve_rec_sized(ctx, n, &bnx_solve_rec_##n); \
+}
+
+BNX_SOLVER_SIZE(6)
+BNX_SOLVER_SIZE(8)
+BNX_SOLVER_SIZE(10)
+BNX_SOLVER_SIZE(12)
+BNX_SOLVER_SIZE(14)
+
+int
+bnx_solve_propagate(struct BnxSolverCtx *ctx)
+{
+	return bnx_solve_trivial(ctx->board, &ctx->stats, 0);
+}
+
+static int
+bnx_solve_run(struct BnxSolverCtx *ctx)
+{
+	// Common sizes run a search specialized for them
+	switch (ctx->board->size) {
+		case 6:
+			return bnx_solve_rec_6(ctx);
+
+		case 8:
+			return bnx_solve_rec_8(ctx);
+
+		case 10:
+			return bnx_solve_rec_10(ctx);
+
+		case 12:
+			return bnx_solve_rec_12(ctx);
+
+		case 14:
+			return bnx_solve_rec_14(ctx);
+
+		default:
+			return bnx_solve_rec(ctx);
+	}
+}
+
+///
+/// \brief Solve the board of a context with the CDCL engine. After every
+/// 	solution a clause over the fields excludes it, until the collector
+/// 	is done or no solution is left.
+///
+/// \param Solver context
+/// \return Error, negative if the formula could not be built or memory ran
+/// 	out during the search
+///
+static int
+bnx_solve_sat(struct BnxSolverCtx *ctx)
+{
+	struct BnxBoard *board = ctx->board;
+	const size_t size = board->size;
+	struct BnxCnf cnf;
+	struct BnxSat sat;
+	int found = false;
+	int row;
+	int col;
+
+	bnx_cnf_init(&cnf, size);
+	int error = bnx_cnf_encode(&cnf, board);
+	if (error == 0) {
+		error = bnx_sat_init(&sat, cnf.vars);
+	}
+	if (error != 0) {
+		bnx_cnf_free(&cnf);
+		return error;
+	}
+	bnx_sat_load(&sat, &cnf);
+	bnx_sat_prefer(&sat, size * size);
+	bnx_cnf_free(&cnf);
+
+	while (!bnx_collector_done(ctx->collector)) {
+		error = bnx_sat_solve(&sat);
+		if (error != BNX_SAT_SAT) {
+			break;
+		}
+
+		bnx_board_init(board, size);
+		for (row = 0; row < size; row++) {
+			for (col = 0; col < size; col++) {
+				bnx_board_set(board, row, col,
+					bnx_sat_value(&sat, bnx_cnf_field(size, row, col))
+					? BNX_FIELD_X : BNX_FIELD_O);
 			}
 		}
-	
-		free(child);
 
-	} else if (error == BNX_CORRECT && ctx->free_solutions != 0) {
+		found = true;
+		if (!bnx_collector_add(ctx->collector, board)
+		    || !bnx_sat_block(&sat, size * size)) {
+			break;
+		}
+	}
+
+	ctx->stats.nodes += sat.decisions;
+	BNX_STATS_ADD(&ctx->stats, backtracks, sat.conflicts);
+	BNX_STATS_ADD(&ctx->stats, restarts, sat.restarts);
+
+	// Blocking a solution may have run out of memory as well
+	error = sat.error;
+	bnx_sat_free(&sat);
+
+	if (error < 0) {
+		return error;
+	}
+	return found ? BNX_CORRECT : BNX_ERR_CONFLICT;
+}
+
+int
+bnx_solve_ctx(struct BnxSolverCtx *ctx)
+{
+	if (ctx->sat) {
+		return bnx_solve_sat(ctx);
+	}
+
+	// Restarts are for finding a solution, they would repeat solutions
+	// of complete searches and branches already handed to other threads
+	if (!ctx->restart || ctx->spawn != NULL
+	    || atomic_load(&ctx->collector->free_solutions) != 1) {
+		return bnx_solve_run(ctx);
+	}
+
+	struct BnxBoard *root = bnx_arena_get(&ctx->arena);
+	if (root == NULL) {
+		return bnx_solve_run(ctx);
+	}
+	bnx_board_copy(root, ctx->board);
+
+	unsigned long run;
+	int error = BNX_CORRECT;
 
-		struct BnxSolution *solution = bnx_solution_alloc();
-		solution->data = ctx->current;
-		solution->next = ctx->solution;
-		ctx->solution = solution;
+	for (run = 1; ; run++) {
+		ctx->budget  = BNX_RESTART_NODES * bnx_luby(run);
+		ctx->aborted = false;
 
-		if (ctx->free_solutions != BNX_SOLUTION_MODE_ALL) {
-			ctx->free_solutions--;
+		error = bnx_solve_run(ctx);
+		if (!ctx->aborted || bnx_collector_done(ctx->collector)) {
+			break;
 		}
 
-	} 
+		BNX_STATS_ADD(&ctx->stats, restarts, 1);
+		bnx_board_copy(ctx->board, root);
+	}
+
+	ctx->budget  = 0;
+	ctx->aborted = false;
+	bnx_arena_put(&ctx->arena, root);
 
-bnx_solve_rec_shortcut:
 	return error;
 }
 
 struct BnxSolution *
 bnx_solve(struct Bnx const * const b, const int mode, const int sol_mode)
 {
-	struct BnxSolverCtx *ctx = bnx_ctx_alloc(b, mode, sol_mode);
+	return bnx_solve_stats(b, mode, sol_mode, NULL);
+}
+
+///
+/// \brief Search a binoxxo with a single context
+///
+/// \param Binoxxo data structure
+/// \param Guess mode
+/// \param Collector
+/// \param Statistics of the search, may be NULL
+/// \return Error
+///
+static int
+bnx_solve_collect(struct Bnx const * const b, const int mode,
+                  struct BnxCollector *collector, struct BnxStats *stats)
+{
+	bnx_lines_init();
+
+	struct BnxSolverCtx *ctx = bnx_ctx_alloc(b, mode, collector);
+	if (ctx == NULL) {
+		return -ENOMEM;
+	}
 
 #ifdef BNX_TIMING
-	const clock_t start = clock();
+	struct timespec start;
+	timespec_get(&start, TIME_UTC);
 #endif
 
-	bnx_solve_rec(ctx);	
+	const int error = bnx_solve_ctx(ctx);
 
 #ifdef BNX_TIMING
-	const clock_t end = clock();
-	printf("Time: %.2f s\n", (double)(end - start) / CLOCKS_PER_SEC);
+	struct timespec end;
+	timespec_get(&end, TIME_UTC);
+	printf("Time: %.6f s\n", (double)(end.tv_sec - start.tv_sec)
+		+ (double)(end.tv_nsec - start.tv_nsec) / 1e9);
 #endif
 
-	struct BnxSolution *solutions = ctx->solution;
+	if (stats != NULL) {
+		*stats = ctx->stats;
+	}
+
 	bnx_ctx_free(ctx);
 
-    return solutions;
+	// Board errors only tell whether a solution was found
+	return error < 0 ? error : 0;
 }
 
+struct BnxSolution *
+bnx_solve_stats(struct Bnx const * const b, const int mode,
+                const int sol_mode, struct BnxStats *stats)
+{
+	return bnx_solve_cached(b, mode, sol_mode, NULL, stats);
+}
+
+struct BnxSolution *
+bnx_solve_cached(struct Bnx const * const b, const int mode,
+                 const int sol_mode, struct BnxCache *cache,
+                 struct BnxStats *stats)
+{
+	struct BnxCollector collector;
+	struct BnxSolution *s;
+
+	// Without guesses the search ends before all solutions are known
+	if (mode == BNX_GUESS_NONE) {
+		cache = NULL;
+	}
+
+	if (cache != NULL && b != NULL
+	    && bnx_cache_get(cache, b, sol_mode, &s)) {
+		if (stats != NULL) {
+			memset(stats, 0, sizeof(struct BnxStats));
+		}
+		return s;
+	}
+
+	bnx_collector_init(&collector, sol_mode);
+	const int error = bnx_solve_collect(b, mode, &collector, stats);
+	s = bnx_collector_destroy(&collector);
+
+	if (cache != NULL && error == 0) {
+		bnx_cache_put(cache, b, sol_mode, s);
+	}
+
+	return s;
+}
+
+long
+bnx_solve_visit(struct Bnx const * const b, const int mode,
+                BnxVisitorFnc visitor, void *data, struct BnxStats *stats)
+{
+	struct BnxCollector collector;
+
+	bnx_collector_init_visit(&collector, visitor, data);
+	const int error = bnx_solve_collect(b, mode, &collector, stats);
+	bnx_collector_destroy(&collector);
+
+	return error < 0 ? error : (long)collector.count;
+}
+
+long
+bnx_count(struct Bnx const * const b, const int mode, const int limit,
+          struct Bnx *witness)
+{
+	struct BnxCollector collector;
+
+	if (witness != NULL && (b == NULL || witness->size != b->size)) {
+		return -EINVAL;
+	}
+
+	bnx_collector_init_count(&collector, limit, witness);
+	const int error = bnx_solve_collect(b, mode, &collector, NULL);
+	bnx_collector_destroy(&collector);
+
+	return error < 0 ? error : (long)collector.count;
+}
@@ -20,9 +20,15 @@
 #ifndef BINOXXO_SOLVER_H
 #define BINOXXO_SOLVER_H
 
+#include <pthread.h>
+#include <stdatomic.h>
+
 #include "binoxxo.h"
+#include "binoxxo_lines.h"
 #include "binoxxo_solver_ctx.h"
 
+struct BnxCache;
+
 ///
 /// Enable time measuring of solving function for binoxxo
 ///
@@ -37,6 +43,99 @@ struct BnxSolution {
 	struct BnxSolution *next;
 };
 
+///
+/// Function pointer for a solution visitor
+/// Takes as argument a solution, which is only borrowed for the call, and
+/// the data passed along with the visitor
+/// Returns true to continue the search, false to stop it
+///
+typedef int (*BnxVisitorFnc)(struct Bnx const *, void *);
+
+///
+/// Thread-safe collector of the solutions found by one or more searches
+///
+struct BnxCollector {
+	pthread_mutex_t lock;
+	struct BnxSolution *solution;
+	BnxVisitorFnc visitor;			// Called for every solution, may be NULL
+	void *data;						// Passed to the visitor
+	struct Bnx *visited;			// Solution handed to the visitor
+	struct Bnx *witness;			// Copy of the first solution, may be NULL
+	unsigned long count;			// Solutions found
+	atomic_int free_solutions;		// Free slots for solutions
+};
+
+///
+/// \brief Initialize a solution collector which builds a solution list
+///
+/// \param Collector
+/// \param Solution mode
+///
+void
+bnx_collector_init(struct BnxCollector *, const int);
+
+///
+/// \brief Initialize a collector which hands every solution to a visitor.
+/// 	Visitors of a parallel search are called by one thread at a time.
+///
+/// \param Collector
+/// \param Visitor
+/// \param Data passed to the visitor
+///
+void
+bnx_collector_init_visit(struct BnxCollector *, BnxVisitorFnc, void *);
+
+///
+/// \brief Initialize a collector which only counts solutions. No solution
+/// 	list is built, only the first solution is copied into the witness.
+///
+/// \param Collector
+/// \param Number of solutions after which the search stops, or
+/// 	BNX_SOLUTION_MODE_ALL
+/// \param Binoxxo of the searched size for the first solution, may be NULL
+///
+void
+bnx_collector_init_count(struct BnxCollector *, const int, struct Bnx *);
+
+///
+/// \brief Count a solved board and hand it to the visitor
+///
+/// \param Collector
+/// \param Solved board
+/// \return True if the solution was taken, false if no slot was free
+///
+int
+bnx_collector_add(struct BnxCollector *, struct BnxBoard const * const);
+
+///
+/// \brief Check whether all solution slots are used up
+///
+/// \param Collector
+/// \return True if the search can stop
+///
+int
+bnx_collector_done(struct BnxCollector *);
+
+///
+/// \brief Solution visitor which pushes a copy of every solution onto a
+/// 	solution list
+///
+/// \param Solution
+/// \param Head of the solution list, a struct BnxSolution **
+/// \return True unless memory ran out
+///
+int
+bnx_visitor_list(struct Bnx const *, void *);
+
+///
+/// \brief Release a collector and hand over the collected solutions
+///
+/// \param Collector
+/// \return Solutions
+///
+struct BnxSolution *
+bnx_collector_destroy(struct BnxCollector *);
+
 ///
 /// \brief Allocate linked list with binoxxo solutions
 ///
@@ -65,9 +164,14 @@ bnx_solution_free(struct BnxSolution *);
 /// 	3. Check for lines with maximum amount of a letter
 /// 	(size / 2 == amount of a letter) fill line with inverted letters
 ///
-/// 	If previous steps have modified data then repeat first 3 steps
-/// 	otherwise look for the line with the greatest amount of letters and
-/// 	make a guess
+/// 	4. Up to BNX_LINES_MAX_SIZE compare the line with all legal lines
+/// 	that match it and are not used yet, set the fields all of them agree
+/// 	on
+///
+/// 	The steps are run on a queue of lines. Whenever a field is set its
+/// 	row and column are queued again. If the queue runs empty and the
+/// 	binoxxo is not complete, the guesser picks a field and both values
+/// 	are tried
 ///
 /// \param Binoxxo data structure
 /// \param Guess mode
@@ -77,5 +181,89 @@ bnx_solution_free(struct BnxSolution *);
 struct BnxSolution *
 bnx_solve(struct Bnx const * const, const int, const int);
 
+///
+/// \brief Solve a binoxxo like bnx_solve and report statistics
+///
+/// \param Binoxxo data structure
+/// \param Guess mode
+/// \param Solution mode
+/// \param Statistics of the search, may be NULL. Zero on a cache hit.
+/// \return Solutions
+///
+struct BnxSolution *
+bnx_solve_stats(struct Bnx const * const, const int, const int,
+                struct BnxStats *);
+
+///
+/// \brief Solve a binoxxo like bnx_solve_stats, but look up puzzles
+/// 	equivalent to one solved before in a cache. Only searches which ran
+/// 	to the end are stored, so BNX_GUESS_NONE, which does not guess, and
+/// 	searches which failed bypass the cache. The cache may be shared by
+/// 	threads, the parallel and batch solvers do not use one.
+///
+/// \param Binoxxo data structure
+/// \param Guess mode
+/// \param Solution mode
+/// \param Cache, NULL to always search
+/// \param Statistics of the search, may be NULL. Zero on a cache hit.
+/// \return Solutions
+///
+struct BnxSolution *
+bnx_solve_cached(struct Bnx const * const, const int, const int,
+                 struct BnxCache *, struct BnxStats *);
+
+///
+/// \brief Solve a binoxxo like bnx_solve, but hand every solution to a
+/// 	visitor as soon as it is found instead of building a solution list.
+/// 	The search runs until it is complete or the visitor stops it.
+///
+/// \param Binoxxo data structure
+/// \param Guess mode
+/// \param Visitor
+/// \param Data passed to the visitor
+/// \param Statistics of the search, may be NULL
+/// \return Number of visited solutions, negative on error
+///
+long
+bnx_solve_visit(struct Bnx const * const, const int, BnxVisitorFnc, void *,
+                struct BnxStats *);
+
+///
+/// \brief Count the solutions of a binoxxo up to a limit. The search stops
+/// 	at the limit and no solution list is allocated, so for example a
+/// 	limit of 2 tells apart puzzles with none, one or several solutions.
+///
+/// \param Binoxxo data structure
+/// \param Guess mode
+/// \param Number of solutions after which the search stops, or
+/// 	BNX_SOLUTION_MODE_ALL
+/// \param Binoxxo of the same size for the first solution, may be NULL
+/// \return Number of solutions, negative on error
+///
+long
+bnx_count(struct Bnx const * const, const int, const int, struct Bnx *);
+
+///
+/// \brief Apply the rules to the queued lines of the board of a context
+/// 	until nothing changes, without guessing
+///
+/// \param Solver context
+/// \return Error of the board after propagation
+///
+int
+bnx_solve_propagate(struct BnxSolverCtx *);
+
+///
+/// \brief Search the board of a context and hand all solutions to the
+/// 	collector of the context. A single-threaded search for one solution
+/// 	with the random guesser is restarted from the start whenever a run
+/// 	exceeds its node budget, the budgets follow the Luby sequence.
+///
+/// \param Solver context
+/// \return Error of the board after propagation
+///
+int
+bnx_solve_ctx(struct BnxSolverCtx *);
+
 #endif // BINOXXO_SOLVER_H
 
@@ -17,35 +17,9 @@
 // 
 
 
-#include "binoxxo_solver_ctx.h"
-
-static struct Bnx *
-bnx_alloc_guess_map(struct Bnx const * const b)
-{
-	struct Bnx *map = bnx_alloc(b->size);
-
-	bnx_update_guess_map(map, b);
-
-	return map;
-}
-
-void
-bnx_update_guess_map(struct Bnx const *map, struct Bnx const *b)
-{
-	const size_t size = b->size;
-	int row;
-	int col;
+#define _POSIX_C_SOURCE 200809L
 
-	for (row = 0; row < size; row++) {
-		for (col = 0; col < size; col++) {
-			int guess = BNX_FIELD_OVER;
-			if (b->data[row][col] == BNX_FIELD_EMPTY) {
-				guess = BNX_FIELD_EMPTY;
-			}
-			map->data[row][col] = guess;
-		}
-	}
-}
+#include "binoxxo_solver_ctx.h"
 
 static BnxGuesserFnc
 bnx_get_guesser(const int mode)
@@ -60,6 +34,9 @@ bnx_get_guesser(const int mode)
 		case BNX_GUESS_NONE:
 			return &bnx_guesser_none;
 
+		case BNX_GUESS_CONSTRAINED:
+			return &bnx_guesser_constrained;
+
 		case BNX_GUESS_MOSTFILLED:
 		default:
 			return &bnx_guesser_mostfilled;
@@ -67,147 +44,336 @@ bnx_get_guesser(const int mode)
 }
 
 struct BnxSolverCtx *
-bnx_ctx_alloc(struct Bnx const * const b, const int mode, const int sol_mode)
+bnx_ctx_alloc(struct Bnx const * const b, const int mode,
+              struct BnxCollector *collector)
 {
 	struct BnxSolverCtx *ctx = malloc(sizeof(struct BnxSolverCtx));
+	if (ctx == NULL) {
+		fprintf(stderr, "Could not allocate memory for solver context\n");
+		return NULL;
+	}
 
-	ctx->root = bnx_alloc(b->size);
-	bnx_copy(ctx->root, b);
+	bnx_arena_init(&ctx->arena, sizeof(struct BnxBoard), BNX_CTX_ARENA_CHUNK);
 
-	ctx->current		= ctx->root;
-	ctx->guess_map      = bnx_alloc_guess_map(b);
+	ctx->board = bnx_arena_get(&ctx->arena);
+	if (ctx->board == NULL || bnx_board_pack(ctx->board, b) != 0) {
+		fprintf(stderr, "Could not create board\n");
+		bnx_arena_free(&ctx->arena);
+		free(ctx);
+		return NULL;
+	}
+
+	ctx->collector      = collector;
 	ctx->guesser        = bnx_get_guesser(mode);
-	ctx->free_solutions = sol_mode;
+	ctx->spawn          = NULL;
+	ctx->worker         = NULL;
+	ctx->restart        = mode == BNX_GUESS_RANDOM;
+	ctx->sat            = mode == BNX_GUESS_SAT;
+	ctx->budget         = 0;
+	ctx->aborted        = false;
+
+	bnx_random_seed(&ctx->random, BNX_RANDOM_SEED);
+
+	memset(&ctx->stats, 0, sizeof(struct BnxStats));
+	BNX_STATS_MAX(&ctx->stats, boards, 1);
 
 	return ctx;
 }
 
+int
+bnx_ctx_load(struct BnxSolverCtx *ctx, struct Bnx const * const b)
+{
+	memset(&ctx->stats, 0, sizeof(struct BnxStats));
+	BNX_STATS_MAX(&ctx->stats, boards, 1);
+
+	// The random state carries over, following binoxxos get other guesses
+	ctx->budget  = 0;
+	ctx->aborted = false;
+
+	return bnx_board_pack(ctx->board, b);
+}
+
+void
+bnx_ctx_seed(struct BnxSolverCtx *ctx, const uint64_t seed)
+{
+	bnx_random_seed(&ctx->random, seed);
+}
+
 void
 bnx_ctx_free(struct BnxSolverCtx *ctx)
 {
-	bnx_free(ctx->guess_map);
-	bnx_free(ctx->root);
+	bnx_arena_free(&ctx->arena);
 	free(ctx);
 }
 
-struct Bnx **
-bnx_guesser_topleft(struct BnxSolverCtx const *ctx)
+unsigned long
+bnx_luby(const unsigned long i)
 {
-	const size_t size = ctx->current->size;
-	int col;
-	int row;
+	unsigned long k = 1;
+
+	// 1, 1, 2, 1, 1, 2, 4, 1, 1, 2, 1, 1, 2, 4, 8, ...
+	while (((1ul << k) - 1) < i) {
+		k++;
+	}
 
-	struct Bnx **child = malloc(sizeof(struct Bnx *) * 2);
+	if (((1ul << k) - 1) == i) {
+		return 1ul << (k - 1);
+	}
+
+	return bnx_luby(i - (1ul << (k - 1)) + 1);
+}
 
+double
+bnx_stats_now(void)
+{
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (double)now.tv_sec + (double)now.tv_nsec / 1e9;
+}
+
+void
+bnx_stats_merge(struct BnxStats *stats, struct BnxStats const * const add)
+{
 	int i;
-	for (i = 0; i < 2; i++) {
-		child[i] = bnx_alloc(size);
-		bnx_copy(child[i], ctx->current);
+
+	stats->nodes       += add->nodes;
+	stats->backtracks  += add->backtracks;
+	stats->validations += add->validations;
+	stats->restarts    += add->restarts;
+	stats->propagation += add->propagation;
+	stats->validation  += add->validation;
+	stats->guessing    += add->guessing;
+	for (i = 0; i < BNX_RULES; i++) {
+		stats->forced[i] += add->forced[i];
 	}
 
-	for (row = 0; row < size; row++) {
-		for (col = 0; col < size; col++) {
+	BNX_STATS_MAX(stats, max_depth, add->max_depth);
+	BNX_STATS_MAX(stats, boards, add->boards);
+}
 
-			int *field = &ctx->guess_map->data[row][col];
-			if (*field == BNX_FIELD_EMPTY) {
+static int
+bnx_guess_set(struct BnxGuess *guess, const int row, const int col)
+{
+	guess->row   = row;
+	guess->col   = col;
+	guess->field = BNX_FIELD_O;
 
-				child[0]->data[row][col] = BNX_FIELD_O;
-				child[1]->data[row][col] = BNX_FIELD_X;
+	return true;
+}
 
-				*field = BNX_FIELD_OVER;
-				return child;
-			}
+int
+bnx_guesser_topleft(struct BnxSolverCtx *ctx, struct BnxGuess *guess)
+{
+	const size_t size = ctx->board->size;
+	int row;
+
+	for (row = 0; row < size; row++) {
 
+		const BnxMask empty = bnx_board_empty(ctx->board, BNX_DIR_H, row);
+		if (empty) {
+			return bnx_guess_set(guess, row, bnx_mask_first(empty));
 		}
 	}
 
-	bnx_free(child[0]);
-	bnx_free(child[1]);
-	free(child);
-
-	return NULL;
+	return false;
 }
 
-struct Bnx **
-bnx_guesser_mostfilled(struct BnxSolverCtx const *ctx)
+int
+bnx_guesser_mostfilled(struct BnxSolverCtx *ctx, struct BnxGuess *guess)
 {
-	const size_t size = ctx->current->size;
+	const size_t size = ctx->board->size;
 	int i;
 	int empty_fields;
-	int min_row = size;
-	int min_col = size;
+	int min_row = size + 1;
+	int min_col = size + 1;
 	int row = 0;
 	int col = 0;
 
-	struct Bnx **child = malloc(sizeof(struct Bnx *) * 2);
-
-	for (i = 0; i < 2; i++) {
-		child[i] = bnx_alloc(size);
-		bnx_copy(child[i], ctx->current);
-	}
-
-	struct BnxLine *line;
-
 	for (i = 0; i < size; i++) {
 
-		line = bnx_get_line(ctx->current, BNX_SCAN_H, i);
-		empty_fields = bnx_line_count_empty(line);
+		empty_fields = bnx_board_count_empty(ctx->board, BNX_DIR_H, i);
 
-		if (empty_fields < min_row) {
+		if (empty_fields > 0 && empty_fields < min_row) {
 			min_row = empty_fields;
 			row = i;
 		}
 
-		bnx_free_line(line);
-
-		line = bnx_get_line(ctx->current, BNX_SCAN_V, i);
-		empty_fields = bnx_line_count_empty(line);
+		empty_fields = bnx_board_count_empty(ctx->board, BNX_DIR_V, i);
 
-		if (empty_fields < min_col) {
+		if (empty_fields > 0 && empty_fields < min_col) {
 			min_col = empty_fields;
 			col = i;
 		}
+	}
 
-		bnx_free_line(line);
+	if (min_row > size && min_col > size) {
+		return false;
 	}
 
 	if (min_row < min_col) {
-		line = bnx_get_line(ctx->current, BNX_SCAN_H, row);
+		col = bnx_mask_first(bnx_board_empty(ctx->board, BNX_DIR_H, row));
 	} else {
-		line = bnx_get_line(ctx->current, BNX_SCAN_V, col);
+		row = bnx_mask_first(bnx_board_empty(ctx->board, BNX_DIR_V, col));
+	}
+
+	return bnx_guess_set(guess, row, col);
+}
+
+int
+bnx_guesser_random(struct BnxSolverCtx *ctx, struct BnxGuess *guess)
+{
+	const size_t size = ctx->board->size;
+	int empty = 0;
+	int row;
+
+	for (row = 0; row < size; row++) {
+		empty += bnx_board_count_empty(ctx->board, BNX_DIR_H, row);
 	}
 
+	if (empty == 0) {
+		return false;
+	}
+
+	// Walk to the chosen empty field row by row
+	int pick = bnx_random_below(&ctx->random, empty);
+	for (row = 0; row < size; row++) {
+		const int count = bnx_board_count_empty(ctx->board, BNX_DIR_H, row);
+		if (pick < count) {
+			break;
+		}
+		pick -= count;
+	}
+
+	BnxMask fields = bnx_board_empty(ctx->board, BNX_DIR_H, row);
+	while (pick-- > 0) {
+		fields &= fields - 1;
+	}
+
+	bnx_guess_set(guess, row, bnx_mask_first(fields));
+	if (bnx_random_next(&ctx->random) >> 63) {
+		guess->field = BNX_FIELD_X;
+	}
+
+	return true;
+}
+
+///
+/// \brief Freedom of a line, the smaller of the numbers of o's and x's it
+/// 	can still take. Derived from the running counts of the board, so it
+/// 	follows every set and undo without any extra bookkeeping.
+///
+/// \param Board
+/// \param Direction
+/// \param Index
+/// \return Freedom
+///
+static inline int
+bnx_line_freedom(struct BnxBoard const * const board, const int dir,
+                 const int index)
+{
+	const int half = board->size / 2;
+	const int o = half - board->count_o[dir][index];
+	const int x = half - board->count_x[dir][index];
+
+	return o < x ? o : x;
+}
+
+int
+bnx_guesser_constrained(struct BnxSolverCtx *ctx, struct BnxGuess *guess)
+{
+	struct BnxBoard const * const board = ctx->board;
+	const size_t size = board->size;
+	BnxMask level[BNX_MAX_SIZE / 2 + 1] = { 0 };	// Columns by freedom
+	int min_level = size;
+	int max_level = 0;
+	int best = size + 1;
+	int best_empty = 0;
+	int row = -1;
+	int col = -1;
+	int i;
+
+	// Bucket the open columns by their freedom
 	for (i = 0; i < size; i++) {
-		if (*line->data[i] == BNX_FIELD_EMPTY) {
-			if (min_row < min_col) {
-				col = i;
-			} else {
+		if (bnx_board_count_empty(board, BNX_DIR_V, i) == 0) {
+			continue;
+		}
+
+		const int f = bnx_line_freedom(board, BNX_DIR_V, i);
+		level[f] |= (BnxMask)1 << i;
+		if (f < min_level) {
+			min_level = f;
+		}
+		if (f > max_level) {
+			max_level = f;
+		}
+	}
+
+	for (i = 0; i < size && best > 0; i++) {
+
+		const BnxMask empty = bnx_board_empty(board, BNX_DIR_H, i);
+		const int f = bnx_line_freedom(board, BNX_DIR_H, i);
+		if (empty == 0 || f + min_level > best) {
+			continue;
+		}
+
+		// The least free column crossing an empty field of this row
+		int l;
+		for (l = min_level; l <= max_level && f + l <= best; l++) {
+
+			const BnxMask fields = empty & level[l];
+			if (fields == 0) {
+				continue;
+			}
+
+			// Ties go to the pair of lines with fewer empty fields
+			const int c = bnx_mask_first(fields);
+			const int e = bnx_board_count_empty(board, BNX_DIR_H, i)
+				+ bnx_board_count_empty(board, BNX_DIR_V, c);
+			if (f + l < best || e < best_empty) {
+				best = f + l;
+				best_empty = e;
 				row = i;
+				col = c;
 			}
 			break;
 		}
 	}
 
-    bnx_free_line(line);
+	if (row < 0) {
+		return false;
+	}
 
-	ctx->guess_map->data[row][col] = BNX_FIELD_OVER;
+	bnx_guess_set(guess, row, col);
 
-	child[0]->data[row][col] = BNX_FIELD_O;
-	child[1]->data[row][col] = BNX_FIELD_X;
+	const int half = size / 2;
+	const int o_full = board->count_o[BNX_DIR_H][row] >= half
+		|| board->count_o[BNX_DIR_V][col] >= half;
+	const int x_full = board->count_x[BNX_DIR_H][row] >= half
+		|| board->count_x[BNX_DIR_V][col] >= half;
 
-	return child;
-}
+	// A value one of the lines has no room for fails, try the other first
+	if (o_full != x_full) {
+		if (o_full) {
+			guess->field = BNX_FIELD_X;
+		}
+		return true;
+	}
 
-struct Bnx **
-bnx_guesser_random(struct BnxSolverCtx const *ctx)
-{
-    // todo implement
-	return NULL;
+	// Otherwise try the scarcer value first, it uses up the budget of the
+	// lines and forces their remaining fields
+	const int o = board->count_o[BNX_DIR_H][row]
+		+ board->count_o[BNX_DIR_V][col];
+	const int x = board->count_x[BNX_DIR_H][row]
+		+ board->count_x[BNX_DIR_V][col];
+	if (x > o) {
+		guess->field = BNX_FIELD_X;
+	}
+
+	return true;
 }
 
-struct Bnx **
-bnx_guesser_none(struct BnxSolverCtx const *ctx)
+int
+bnx_guesser_none(struct BnxSolverCtx *ctx, struct BnxGuess *guess)
 {
-	return NULL;
+	return false;
 }
-
@@ -21,12 +21,32 @@
 #define BINOXXO_SOLVER_CTX_H
 
 #include "binoxxo.h"
+#include "binoxxo_arena.h"
+#include "binoxxo_board.h"
+#include "binoxxo_random.h"
+
+///
+/// Statistics of the search are only collected in struct BnxStats if
+/// BNX_STATS is defined, for example by "make stats". Otherwise all
+/// counters and timers compile out.
+///
 
 ///
 /// Constant for inverting a field's value
 ///
 #define BNX_INVERT_FIELD (-1)
 
+///
+/// Boards allocated at once by the arena of a solver context
+///
+#define BNX_CTX_ARENA_CHUNK 4
+
+///
+/// Nodes of the shortest run of a search with restarts, the budget of run
+/// i is this times the i-th element of the Luby sequence
+///
+#define BNX_RESTART_NODES 64
+
 ///
 /// Guess algorithm
 ///
@@ -35,6 +55,9 @@ enum BnxGuessMode {
 	BNX_GUESS_TOPLEFT,
 	BNX_GUESS_MOSTFILLED,
 	BNX_GUESS_RANDOM,
+	BNX_GUESS_CONSTRAINED,
+	BNX_GUESS_SAT,			// No guesses, the CDCL engine of binoxxo_sat
+							// solves the binoxxo
 };
 
 ///
@@ -45,48 +68,128 @@ enum BnxSolutionMode {
 	BNX_SOLUTION_MODE_ONE = 1,
 };
 
+///
+/// Propagation rules, in the order they are applied
+///
+enum BnxRule {
+	BNX_RULE_DOUBLE,
+	BNX_RULE_TRIPLE,
+	BNX_RULE_COUNT,
+	BNX_RULE_LINES,
+	BNX_RULES,
+};
+
+///
+/// Statistics of a search. Without BNX_STATS only the nodes are counted,
+/// which costs one increment per node, all other fields stay zero.
+///
+struct BnxStats {
+	unsigned long nodes;			// Search nodes visited
+	unsigned long backtracks;		// Branches undone
+	unsigned long depth;			// Current guess depth
+	unsigned long max_depth;
+	unsigned long forced[BNX_RULES];	// Fields set by each rule
+	unsigned long validations;
+	unsigned long restarts;
+	unsigned long boards;			// Peak boards alive
+	double propagation;				// Seconds spent in each phase
+	double validation;
+	double guessing;
+};
+
+#ifdef BNX_STATS
+#define BNX_STATS_ADD(s, field, n)	((s)->field += (n))
+#define BNX_STATS_MAX(s, field, n) \
+	((s)->field = (n) > (s)->field ? (n) : (s)->field)
+#define BNX_STATS_START(t)			const double t = bnx_stats_now()
+#define BNX_STATS_STOP(s, field, t)	((s)->field += bnx_stats_now() - (t))
+#else
+#define BNX_STATS_ADD(s, field, n)	((void)0)
+#define BNX_STATS_MAX(s, field, n)	((void)0)
+#define BNX_STATS_START(t)
+#define BNX_STATS_STOP(s, field, t)	((void)0)
+#endif
+
 // Forward definition
 struct BnxSolverCtx;
+struct BnxCollector;
 
 ///
-/// Function pointer for a guesser function
-/// Takes as a solver context and a binoxxo
-/// Returns modification status
+/// Field chosen by a guesser and the value to try first
 ///
-typedef struct Bnx ** (*BnxGuesserFnc)(struct BnxSolverCtx const *);
+struct BnxGuess {
+	int row;
+	int col;
+	int field;
+};
 
 ///
-/// Hold current solver context including a map of guesses,
-/// the solution tree and a pointer to the current root 
+/// Function pointer for a guesser function
+/// Takes as a solver context and the guess to fill
+/// Returns true if an empty field was found
 ///
-struct BnxSolverCtx {
-	struct Bnx *guess_map;
-	struct Bnx *root;
-	struct Bnx *current;			// Pointer to current node
-	struct BnxSolution *solution;
-	BnxGuesserFnc guesser;
-	int free_solutions;				// Free slots for solutions
-};
+typedef int (*BnxGuesserFnc)(struct BnxSolverCtx *, struct BnxGuess *);
 
 ///
-/// \brief Update guess map of a context
+/// Function pointer for handing a branch of the search to another thread
+/// Takes as argument a solver context and the field and value of the branch
+/// Returns true if the branch was taken over
 ///
-/// \param Solver context
-/// \param Guess map
+typedef int (*BnxSpawnFnc)(struct BnxSolverCtx *, const int, const int,
+                           const int);
+
 ///
-void
-bnx_update_guess_map(const struct Bnx *, const struct Bnx *);
+/// Hold current solver context including the solutions and the board that
+/// is searched. Guesses are undone through the trail of the board. All
+/// boards of a search come from the arena of the context and are released
+/// with it.
+///
+struct BnxSolverCtx {
+	struct BnxArena arena;			// Boards
+	struct BnxBoard *board;
+	struct BnxCollector *collector;	// Shared by all threads of a search
+	BnxGuesserFnc guesser;
+	BnxSpawnFnc spawn;				// NULL if single-threaded
+	void *worker;					// Data of the thread running the search
+	struct BnxRandom random;		// Used by the random guesser
+	int restart;					// Restart the search while no solution
+									// is found, see bnx_solve_ctx
+	unsigned long budget;			// Nodes left in this run, 0 if unlimited
+	int aborted;					// Budget of this run used up
+	int sat;						// Solve with the CDCL engine
+	struct BnxStats stats;
+};
 
 ///
 /// \brief Allocate a solver context
 ///
 /// \param Binoxxo data structure
 /// \param Guess mode
-/// \param Solution mode
+/// \param Solution collector
 /// \return Solver context 
 ///
 struct BnxSolverCtx *
-bnx_ctx_alloc(struct Bnx const * const, const int, const int);
+bnx_ctx_alloc(struct Bnx const * const, const int, struct BnxCollector *);
+
+///
+/// \brief Load another binoxxo into a solver context, so one context can
+/// 	be reused for many binoxxos
+///
+/// \param Solver context
+/// \param Binoxxo data structure
+/// \return Error
+///
+int
+bnx_ctx_load(struct BnxSolverCtx *, struct Bnx const * const);
+
+///
+/// \brief Seed the random generator of a solver context
+///
+/// \param Solver context
+/// \param Seed
+///
+void
+bnx_ctx_seed(struct BnxSolverCtx *, const uint64_t);
 
 ///
 /// \brief Free a solver context
@@ -96,16 +199,44 @@ bnx_ctx_alloc(struct Bnx const * const, const int, const int);
 void
 bnx_ctx_free(struct BnxSolverCtx *);
 
+///
+/// \brief Monotonic time for the phase timers of the statistics
+///
+/// \return Seconds
+///
+double
+bnx_stats_now(void);
+
+///
+/// \brief Element of the Luby sequence, which scales the lengths of runs
+/// 	between restarts
+///
+/// \param Index, starting at 1
+/// \return Element
+///
+unsigned long
+bnx_luby(const unsigned long);
+
+///
+/// \brief Add the statistics of another search, for example of another
+/// 	thread. Maxima are merged as maxima.
+///
+/// \param Statistics
+/// \param Statistics to add
+///
+void
+bnx_stats_merge(struct BnxStats *, struct BnxStats const * const);
+
 ///
 /// \brief Guesser function. This function guesses based on it's definition
 /// 	which field should be filled.
 ///
 /// \param Solver context 
-/// \param Binoxxo data structure
-/// \return Guessed solutions
+/// \param Guess
+/// \return True if a field was guessed
 ///
-#define MAKE_GUESSER(g) struct Bnx ** \
-	bnx_guesser_##g (struct BnxSolverCtx const *);
+#define MAKE_GUESSER(g) int \
+	bnx_guesser_##g (struct BnxSolverCtx *, struct BnxGuess *);
 
 ///
 /// Scan from top left field down to bottom left field
@@ -119,10 +250,21 @@ MAKE_GUESSER(topleft)
 MAKE_GUESSER(mostfilled)
 
 ///
-/// Take a random field
+/// Take a random empty field and a random value. Searches with this
+/// guesser restart with growing node budgets until a solution is found.
 ///
 MAKE_GUESSER(random)
 
+///
+/// Take the empty field whose row and column together have the least
+/// freedom, the freedom of a line being the smaller of its remaining o and
+/// x budgets. A value the row or column has no room left for is tried
+/// last. Otherwise the value with less budget left in both lines is tried
+/// first: it forces the remaining fields of the lines, which took about 40%
+/// fewer nodes on the bench corpora than trying the value with more room.
+///
+MAKE_GUESSER(constrained)
+
 ///
 /// Do not guess
 ///
@@ -0,0 +1,141 @@
+// 
+// binoxxo_symmetry.c
+// Copyright (C) 2014  Florian Tanner <florian.tanner@gmail.com>
+// 
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+// 
+
+
+
+
+#include "binoxxo_symmetry.h"
+
+int
+bnx_symmetry_inverse(const int sym)
+{
+	// Flips and the swap undo themselves, but after a transpose the flip
+	// of the rows works on the columns and vice versa
+	if (!(sym & BNX_SYM_TRANSPOSE)) {
+		return sym;
+	}
+
+	int inverse = sym & (BNX_SYM_TRANSPOSE | BNX_SYM_SWAP);
+	if (sym & BNX_SYM_FLIP_COLS) {
+		inverse |= BNX_SYM_FLIP_ROWS;
+	}
+	if (sym & BNX_SYM_FLIP_ROWS) {
+		inverse |= BNX_SYM_FLIP_COLS;
+	}
+
+	return inverse;
+}
+
+///
+/// \brief Get a field of the image of a binoxxo under a symmetry
+///
+/// \param Binoxxo data structure
+/// \param Symmetry
+/// \param Row of the image
+/// \param Column of the image
+/// \return Field value
+///
+static inline int
+bnx_symmetry_field(struct Bnx const *b, const int sym, const int row,
+                   const int col)
+{
+	const int last = b->size - 1;
+	int r = row;
+	int c = col;
+
+	if (sym & BNX_SYM_TRANSPOSE) {
+		r = col;
+		c = row;
+	}
+	if (sym & BNX_SYM_FLIP_ROWS) {
+		r = last - r;
+	}
+	if (sym & BNX_SYM_FLIP_COLS) {
+		c = last - c;
+	}
+
+	const int field = b->data[r][c];
+	if ((sym & BNX_SYM_SWAP)
+	    && (field == BNX_FIELD_O || field == BNX_FIELD_X)) {
+		return -field;
+	}
+
+	return field;
+}
+
+void
+bnx_symmetry_apply(struct Bnx const *dest, struct Bnx const *src,
+                   const int sym)
+{
+	const size_t size = src->size;
+	int row;
+	int col;
+
+	for (row = 0; row < size; row++) {
+		for (col = 0; col < size; col++) {
+			dest->data[row][col] = bnx_symmetry_field(src, sym, row, col);
+		}
+	}
+}
+
+///
+/// \brief Compare the images of a binoxxo under two symmetries field by
+/// 	field, row by row
+///
+/// \param Binoxxo data structure
+/// \param Symmetry
+/// \param Other symmetry
+/// \return Negative, zero or positive like strcmp
+///
+static int
+bnx_symmetry_compare(struct Bnx const *b, const int sym, const int other)
+{
+	const size_t size = b->size;
+	int row;
+	int col;
+
+	for (row = 0; row < size; row++) {
+		for (col = 0; col < size; col++) {
+			const int diff = bnx_symmetry_field(b, sym, row, col)
+				- bnx_symmetry_field(b, other, row, col);
+			if (diff != 0) {
+				return diff;
+			}
+		}
+	}
+
+	return 0;
+}
+
+int
+bnx_canonical(struct Bnx const *dest, struct Bnx const *src)
+{
+	int best = 0;
+	int sym;
+
+	// Images mostly differ in their first fields
+	for (sym = 1; sym < BNX_SYMMETRIES; sym++) {
+		if (bnx_symmetry_compare(src, sym, best) < 0) {
+			best = sym;
+		}
+	}
+
+	bnx_symmetry_apply(dest, src, best);
+
+	return best;
+}
@@ -0,0 +1,76 @@
+// 
+// binoxxo_symmetry.h
+// Copyright (C) 2014  Florian Tanner <florian.tanner@gmail.com>
+// 
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+// 
+
+
+
+
+#ifndef BINOXXO_SYMMETRY_H
+#define BINOXXO_SYMMETRY_H
+
+#include "binoxxo.h"
+
+///
+/// Number of symmetries of a binoxxo, the 8 rotations and mirrors of the
+/// square, each with and without swapping x's and o's. All of them map a
+/// valid binoxxo to a valid binoxxo.
+///
+#define BNX_SYMMETRIES 16
+
+///
+/// Flags of a symmetry, applied in the order transpose, flips and swap.
+/// Any combination is a symmetry, 0 is the identity.
+///
+enum BnxSymmetry {
+	BNX_SYM_FLIP_COLS = 1,		// Mirror left and right
+	BNX_SYM_FLIP_ROWS = 2,		// Mirror top and bottom
+	BNX_SYM_TRANSPOSE = 4,		// Mirror on the main diagonal
+	BNX_SYM_SWAP      = 8,		// Swap x's and o's
+};
+
+///
+/// \brief Get the symmetry which undoes a symmetry
+///
+/// \param Symmetry
+/// \return Inverse symmetry
+///
+int
+bnx_symmetry_inverse(const int);
+
+///
+/// \brief Apply a symmetry to a binoxxo
+///
+/// \param Destination of the same size, must not be the source
+/// \param Source
+/// \param Symmetry
+///
+void
+bnx_symmetry_apply(struct Bnx const *, struct Bnx const *, const int);
+
+///
+/// \brief Get the canonical form of a binoxxo, the lexicographically
+/// 	smallest of its images under all symmetries. Equivalent binoxxos have
+/// 	the same canonical form.
+///
+/// \param Destination of the same size, must not be the source
+/// \param Source
+/// \return Symmetry mapping the source to the canonical form
+///
+int
+bnx_canonical(struct Bnx const *, struct Bnx const *);
+
+#endif // BINOXXO_SYMMETRY_H
@@ -1,18 +1,299 @@
 
+#define _POSIX_C_SOURCE 200809L
+
+#include <unistd.h>
+
 #include "binoxxo.h"
+#include "binoxxo_batch.h"
+#include "binoxxo_cache.h"
+#include "binoxxo_generator.h"
 #include "binoxxo_io.h"
+#include "binoxxo_parallel.h"
+#include "binoxxo_random.h"
 #include "binoxxo_solver.h"
 
+static int
+main_batch(int argc, char **argv, const char *list, const int threads)
+{
+	struct BnxBatch batch;
+	int error = 0;
+	bnx_batch_init(&batch);
+
+	if (list != NULL) {
+		error = bnx_batch_add_list(&batch, list);
+	}
+
+	int i;
+	for (i = optind; i < argc && error == 0; i++) {
+		error = bnx_batch_add_path(&batch, argv[i]);
+	}
+
+	// Without any input read a stream of binoxxos from stdin
+	if (error == 0 && list == NULL && optind == argc) {
+		error = bnx_batch_add_path(&batch, "-");
+	}
+
+	if (error == 0) {
+		error = bnx_batch_run(&batch, BNX_GUESS_TOPLEFT,
+		                      BNX_SOLUTION_MODE_ALL, threads);
+
+		fprintf(stderr, "Solved %zu binoxxos in %.3f s (%.1f binoxxos/s)\n",
+			batch.solved, batch.seconds,
+			batch.seconds > 0 ? batch.solved / batch.seconds : 0.0);
+	}
+
+	bnx_batch_free(&batch);
+
+	return error == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+static int
+main_generate(int argc, char **argv, const int size, const long count,
+              const int threads, const uint64_t seed)
+{
+	FILE *file = stdout;
+
+	if (optind < argc) {
+		file = fopen(argv[optind], "w");
+		if (file == NULL) {
+			fprintf(stderr, "Could not open %s\n", argv[optind]);
+			return EXIT_FAILURE;
+		}
+	}
+
+	const int error = bnx_generate(file, size, count, threads, seed, false);
+
+	if (file != stdout) {
+		fclose(file);
+	}
+
+	return error == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+static int
+main_print(struct Bnx const *b, void *data)
+{
+	long *count = data;
+
+	if ((*count)++ == 0) {
+		puts("Solved binoxxo:\n");
+	}
+	bnx_print(b);
+
+	return true;
+}
+
+static int
+main_cached(struct Bnx *b, const char *file)
+{
+	struct BnxCache cache;
+
+	if (bnx_cache_init(&cache, BNX_CACHE_CAPACITY) != 0) {
+		bnx_free(b);
+		return EXIT_FAILURE;
+	}
+
+	// A missing cache file is written after solving
+	const int error = bnx_cache_load(&cache, file);
+	if (error != 0 && error != -ENOENT) {
+		bnx_cache_free(&cache);
+		bnx_free(b);
+		return EXIT_FAILURE;
+	}
+
+	struct BnxSolution *s = bnx_solve_cached(b, BNX_GUESS_TOPLEFT,
+	                                         BNX_SOLUTION_MODE_ALL, &cache,
+	                                         NULL);
+
+	if (s) {
+		puts("Solved binoxxo:\n");
+
+		struct BnxSolution *ps;
+		for (ps = s; ps; ps = ps->next) {
+			bnx_print(ps->data);
+		}
+	} else {
+		puts("No solution");
+	}
+	fprintf(stderr, "Cache %s\n", cache.hits ? "hit" : "miss");
+
+	const int saved = bnx_cache_save(&cache, file);
+
+	bnx_solution_free(s);
+	bnx_cache_free(&cache);
+	bnx_free(b);
+
+	return saved == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+static int
+main_count(struct Bnx *b, const int limit)
+{
+	struct Bnx *witness = bnx_alloc(b->size);
+	const long count = bnx_count(b, BNX_GUESS_TOPLEFT, limit, witness);
+
+	if (count > 0 && witness != NULL) {
+		puts("First solution:\n");
+		bnx_print(witness);
+	}
+
+	if (count >= 0) {
+		printf("%ld solution%s%s\n", count, count == 1 ? "" : "s",
+			limit > 0 && count == limit ? " or more" : "");
+	}
+
+	bnx_free(witness);
+	bnx_free(b);
+
+	return count >= 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+static int
+main_model(struct Bnx *b, const char *model)
+{
+	struct Bnx *solution = bnx_alloc(b->size);
+	int error = solution ? bnx_read_model(solution, model) : -ENOMEM;
+
+	if (error == 0) {
+		puts("Model:\n");
+		bnx_print(solution);
+
+		// The model has to keep the givens
+		size_t i;
+		for (i = 0; i < b->size * b->size && error == 0; i++) {
+			if (b->data[0][i] != BNX_FIELD_EMPTY
+			    && b->data[0][i] != solution->data[0][i]) {
+				error = -EINVAL;
+			}
+		}
+
+		const int result = bnx_validate(solution);
+		printf("%s", error ? "Model changes given fields\n"
+			: bnx_strerror(result));
+		error = error ? error : result;
+	} else if (error == -ENOENT) {
+		puts("No solution");
+	}
+
+	bnx_free(solution);
+	bnx_free(b);
+
+	return error == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
 int
 main(int argc, char **argv)
 {
+	// Number of threads, 0 for one per processor
+	int threads = 1;
+	int batch = false;
+	char *list = NULL;
+	char *convert = NULL;
+	char *dimacs = NULL;
+	char *model = NULL;
+	char *cache = NULL;
+	int print_stats = false;
+	// Count solutions up to this limit instead of listing them
+	int limit = 0;
+	// Generate puzzles of this size instead of solving
+	int generate = 0;
+	long count = 1;
+	uint64_t seed = BNX_RANDOM_SEED;
+	int opt;
+	while ((opt = getopt(argc, argv, "bc:C:d:g:j:k:l:m:n:r:s")) != -1) {
+		switch (opt) {
+			case 'b':
+				batch = true;
+				break;
+
+			case 'c':
+				convert = optarg;
+				break;
+
+			case 'C':
+				cache = optarg;
+				break;
+
+			case 'd':
+				dimacs = optarg;
+				break;
+
+			case 'g':
+				generate = atoi(optarg);
+				break;
+
+			case 'j':
+				threads = atoi(optarg);
+				break;
+
+			case 'k':
+				count = atol(optarg);
+				break;
+
+			case 'l':
+				batch = true;
+				list = optarg;
+				break;
+
+			case 'm':
+				model = optarg;
+				break;
+
+			case 'n':
+				limit = atoi(optarg);
+				break;
+
+			case 'r':
+				seed = strtoull(optarg, NULL, 0);
+				break;
+
+			case 's':
+				print_stats = true;
+				break;
+
+			default:
+				fprintf(stderr, "Usage: %s [-j threads] [-s] [file]\n"
+					"       %s -C cache [file]\n"
+					"       %s -n limit [file]\n"
+					"       %s -b [-j threads] [-l list] [path...]\n"
+					"       %s -c output input\n"
+					"       %s -d output [file]\n"
+					"       %s -m model [file]\n"
+					"       %s -g size [-k count] [-r seed] [-j threads] "
+					"[output]\n",
+					argv[0], argv[0], argv[0], argv[0], argv[0], argv[0],
+					argv[0], argv[0]);
+				return EXIT_FAILURE;
+		}
+	}
+
+	// Text files are converted to binary files and vice versa
+	if (convert) {
+		if (optind == argc) {
+			fprintf(stderr, "Input file missing\n");
+			return EXIT_FAILURE;
+		}
+		return bnx_convert_file(argv[optind], convert) == 0
+			? EXIT_SUCCESS : EXIT_FAILURE;
+	}
+
+	if (generate > 0) {
+		if (count < 0) {
+			fprintf(stderr, "Count must not be negative\n");
+			return EXIT_FAILURE;
+		}
+		return main_generate(argc, argv, generate, count, threads, seed);
+	}
+
+	if (batch) {
+		return main_batch(argc, argv, list, threads);
+	}
+
 	// Determine unsolved binoxxo file
-	char *file;
-	if (argc == 1) {
-		//file = "./data/6x6_1.binoxxo";
-		file = "./data/14x14_veryhard_2.binoxxo";
-	} else if (argc >= 2) {
-		file = argv[1];
+	//char *file = "./data/6x6_1.binoxxo";
+	char *file = "./data/14x14_veryhard_2.binoxxo";
+	if (optind < argc) {
+		file = argv[optind];
 	}
 
 	struct Bnx *b = bnx_read_file(file);
@@ -24,19 +305,58 @@ main(int argc, char **argv)
 	puts("Read binoxxo:\n");
 	bnx_print(b);
 
-	struct BnxSolution *s =
-		bnx_solve(b, BNX_GUESS_TOPLEFT, BNX_SOLUTION_MODE_ALL);
+	if (limit != 0) {
+		return main_count(b, limit);
+	}
 
-	if (s) {
-		puts("Solved binoxxo:\n");
+	// Export for external SAT solvers and check their models
+	if (dimacs) {
+		const int error = bnx_write_dimacs(b, dimacs);
+		bnx_free(b);
+		return error == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+	}
 
-		struct BnxSolution *ps = s;
-		do {
-			bnx_print(ps->data);
-			ps = ps->next;
-		} while (ps);
+	if (model) {
+		return main_model(b, model);
+	}
+
+	// Equivalent puzzles solved before are looked up
+	if (cache) {
+		return main_cached(b, cache);
+	}
+
+	struct BnxSolution *s = NULL;
+	struct BnxStats stats;
+	if (threads == 1) {
+		// Solutions are printed as soon as they are found
+		long count = 0;
+		if (bnx_solve_visit(b, BNX_GUESS_TOPLEFT, &main_print, &count,
+		                    &stats) <= 0) {
+			puts("No solution");
+		}
 	} else {
-		puts("No solution");
+		s = bnx_solve_parallel(b, BNX_GUESS_TOPLEFT, BNX_SOLUTION_MODE_ALL,
+		                       threads, &stats);
+
+		if (s) {
+			puts("Solved binoxxo:\n");
+
+			struct BnxSolution *ps = s;
+			do {
+				bnx_print(ps->data);
+				ps = ps->next;
+			} while (ps);
+		} else {
+			puts("No solution");
+		}
+	}
+
+	if (print_stats) {
+#ifdef BNX_STATS
+		bnx_stats_print(stdout, &stats);
+#else
+		fprintf(stderr, "Statistics are disabled, build with make stats\n");
+#endif
 	}
 
 	bnx_solution_free(s);
@@ -17,6 +17,11 @@
 // 
 
 
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdlib.h>
+#include <string.h>
+
 #include "test.h"
 
 struct Bnx* bnx_valid_4x4(void)
@@ -47,6 +52,836 @@ struct Bnx* bnx_valid_4x4(void)
 	return b;
 }
 
+static void test_line(void)
+{
+	struct Bnx* test = bnx_valid_4x4();
+	struct BnxLine line;
+
+	bnx_get_line(test, BNX_SCAN_V, 2, &line);
+	assert(*bnx_line_field(&line, 0) == BNX_FIELD_O);
+	assert(*bnx_line_field(&line, 3) == BNX_FIELD_O);
+
+	*bnx_line_field(&line, 1) = BNX_FIELD_EMPTY;
+	assert(test->data[1][2] == BNX_FIELD_EMPTY);
+	assert(bnx_line_count_empty(&line) == 1);
+
+	bnx_free(test);
+}
+
+static void test_duplicate(void)
+{
+	struct Bnx* test = bnx_valid_4x4();
+	int first = -1;
+	int second = -1;
+
+	assert(bnx_find_duplicate(test, BNX_SCAN_H, &first, &second)
+		== BNX_CORRECT);
+
+	memcpy(test->data[3], test->data[1], 4 * sizeof(int));
+	assert(bnx_find_duplicate(test, BNX_SCAN_H, &first, &second)
+		== BNX_ERR_UNIQUE);
+	assert(first == 1 && second == 3);
+	assert(bnx_validate(test) & BNX_ERR_UNIQUE);
+
+	bnx_free(test);
+}
+
+static void test_board(void)
+{
+	struct Bnx* test = bnx_valid_4x4();
+	struct Bnx* copy = bnx_alloc(4);
+	struct BnxBoard board;
+
+	assert(bnx_board_pack(&board, test) == 0);
+	assert(bnx_board_validate(&board) == BNX_CORRECT);
+	assert(bnx_board_get(&board, 2, 1) == BNX_FIELD_O);
+
+	assert(bnx_board_unpack(copy, &board) == 0);
+	assert(memcmp(copy->data[3], test->data[3], 4 * sizeof(int)) == 0);
+
+	bnx_board_init(&board, 4);
+	bnx_board_set(&board, 0, 0, BNX_FIELD_X);
+	bnx_board_set(&board, 0, 1, BNX_FIELD_X);
+	bnx_board_set(&board, 0, 2, BNX_FIELD_X);
+	assert(bnx_board_validate(&board) & BNX_ERR_FOLLOW);
+	assert(bnx_board_validate(&board) & BNX_ERR_BALANCE);
+	assert(bnx_board_validate_dirty(&board) == bnx_board_validate(&board));
+	assert(board.dirty[BNX_DIR_H] == 0);
+	assert(board.follow[BNX_DIR_H] == 1 && board.balance[BNX_DIR_H] == 1);
+	assert(board.follow[BNX_DIR_V] == 0 && board.open[BNX_DIR_H] == 0xf);
+
+	bnx_board_set(&board, 3, 3, BNX_FIELD_O);
+	assert(board.dirty[BNX_DIR_H] == 1 << 3);
+	assert(board.dirty[BNX_DIR_V] == 1 << 3);
+	assert(bnx_board_count_empty(&board, BNX_DIR_V, 3) == 3);
+	assert(bnx_board_validate_dirty(&board) == bnx_board_validate(&board));
+
+	const size_t mark = bnx_board_mark(&board);
+	bnx_board_set(&board, 1, 0, BNX_FIELD_O);
+	bnx_board_set(&board, 1, 1, BNX_FIELD_O);
+	bnx_board_undo(&board, mark);
+	assert(bnx_board_get(&board, 1, 1) == BNX_FIELD_EMPTY);
+	assert(bnx_board_count_empty(&board, BNX_DIR_H, 1) == 4);
+	assert(bnx_board_get(&board, 3, 3) == BNX_FIELD_O);
+	assert(bnx_board_validate_dirty(&board) == bnx_board_validate(&board));
+
+	// All lines of a direction changed at once
+	bnx_board_init(&board, 10);
+	bnx_board_set(&board, 4, 4, BNX_FIELD_O);
+	bnx_board_set(&board, 4, 4, BNX_FIELD_X);
+	assert(bnx_board_validate_dirty(&board) == bnx_board_validate(&board));
+	assert(board.conflict[BNX_DIR_H] == 1 << 4);
+	assert(board.conflict[BNX_DIR_V] == 1 << 4);
+
+	bnx_free(copy);
+	bnx_free(test);
+}
+
+static void test_lines(void)
+{
+	BnxMask const *lines;
+	struct BnxBoard board;
+	struct BnxBits line;
+
+	bnx_lines_init();
+	assert(bnx_lines_get(6, &lines) == 14);
+	assert(bnx_lines_get(8, &lines) == 34);
+	assert(bnx_lines_get(10, &lines) == 84);
+	assert(bnx_lines_get(12, &lines) == 208);
+	assert(bnx_lines_get(14, &lines) == 518);
+	assert(bnx_lines_get(BNX_LINES_MAX_SIZE + 2, &lines) == 0);
+
+	// x_x_ only allows xoxo
+	bnx_board_init(&board, 4);
+	bnx_board_set(&board, 0, 0, BNX_FIELD_X);
+	bnx_board_set(&board, 0, 2, BNX_FIELD_X);
+	bnx_board_get_line(&board, BNX_DIR_H, 0, &line);
+	assert(bnx_lines_scan(&board, BNX_DIR_H, 0, &line));
+	assert(line.x == 0x5 && line.o == 0xa);
+
+	// xxox__ could only become xxoxoo, which the first row already is
+	const char *used = "xxoxoo";
+	int i;
+	bnx_board_init(&board, 6);
+	for (i = 0; i < 6; i++) {
+		bnx_board_set(&board, 0, i,
+		              used[i] == 'x' ? BNX_FIELD_X : BNX_FIELD_O);
+		if (i < 4) {
+			bnx_board_set(&board, 1, i,
+			              used[i] == 'x' ? BNX_FIELD_X : BNX_FIELD_O);
+		}
+	}
+	bnx_board_get_line(&board, BNX_DIR_H, 1, &line);
+	assert(bnx_lines_scan(&board, BNX_DIR_H, 1, &line));
+	assert((line.o & line.x) == 0x30);
+}
+
+static int count_solutions(struct BnxSolution *s)
+{
+	int count = 0;
+	struct BnxSolution *ps = s;
+	while (ps) {
+		assert(bnx_validate(ps->data) == BNX_CORRECT);
+		count++;
+		ps = ps->next;
+	}
+	bnx_solution_free(s);
+	return count;
+}
+
+static void test_parallel(void)
+{
+	struct Bnx* empty = bnx_alloc(6);
+
+	const int serial = count_solutions(
+		bnx_solve(empty, BNX_GUESS_TOPLEFT, BNX_SOLUTION_MODE_ALL));
+	const int parallel = count_solutions(
+		bnx_solve_parallel(empty, BNX_GUESS_TOPLEFT, BNX_SOLUTION_MODE_ALL, 4,
+		                   NULL));
+
+	assert(serial > 1);
+	assert(serial == parallel);
+	assert(count_solutions(bnx_solve_parallel(empty, BNX_GUESS_TOPLEFT,
+		BNX_SOLUTION_MODE_ONE, 4, NULL)) == 1);
+
+	bnx_free(empty);
+}
+
+static void test_simd(void)
+{
+	struct BnxBoard board;
+	struct BnxBits line;
+	struct BnxCheck check;
+	const size_t sizes[] = {4, 14, 34, 64};
+	struct BnxCheckKernel const *kernel;
+	int round;
+	int k;
+
+	// The scalar kernel is always there, the one in use comes first
+	for (k = 0; bnx_check_kernel_get(k) != NULL; k++) {
+	}
+	assert(k >= 1);
+	assert(strcmp(bnx_check_kernel_get(k - 1)->name, "scalar") == 0);
+	assert(strcmp(bnx_check_kernel_get(0)->name, bnx_check_kernel()) == 0);
+
+	srand(1);
+
+	for (round = 0; round < 200; round++) {
+		const size_t size = sizes[round % 4];
+		int row;
+		int col;
+
+		bnx_board_init(&board, size);
+		for (row = 0; row < size; row++) {
+			for (col = 0; col < size; col++) {
+				const int field = rand() % 3 - 1;
+				if (field != BNX_FIELD_EMPTY) {
+					bnx_board_set(&board, row, col, field);
+				}
+			}
+		}
+
+		// Some fields get both values
+		for (row = 0; row < size; row++) {
+			if (rand() % 4 == 0) {
+				bnx_board_set(&board, row, rand() % size,
+				              rand() % 2 ? BNX_FIELD_O : BNX_FIELD_X);
+			}
+		}
+
+		int dir;
+		int i;
+		for (k = 0; (kernel = bnx_check_kernel_get(k)) != NULL; k++) {
+			for (dir = BNX_DIR_H; dir <= BNX_DIR_V; dir++) {
+				kernel->check(&board, dir, &check);
+				for (i = 0; i < size; i++) {
+					bnx_board_get_line(&board, dir, i, &line);
+					const int error = bnx_bits_validate(&line);
+					const BnxMask bit = (BnxMask)1 << i;
+					assert(!(error & BNX_ERR_FILL) == !(check.fill & bit));
+					assert(!(error & BNX_ERR_CONFLICT)
+					       == !(check.conflict & bit));
+					assert(!(error & BNX_ERR_FOLLOW)
+					       == !(check.follow & bit));
+					assert(!(error & BNX_ERR_BALANCE)
+					       == !(check.balance & bit));
+				}
+
+				// No bits beyond the lines of the board
+				const BnxMask outside = ~board.full;
+				assert(!((check.fill | check.conflict | check.follow
+				          | check.balance) & outside));
+			}
+		}
+	}
+}
+
+static void test_arena(void)
+{
+	struct BnxArena arena;
+
+	bnx_arena_init(&arena, 3, 2);
+	assert(arena.object >= sizeof(void *));
+
+	char *a = bnx_arena_get(&arena);
+	char *b = bnx_arena_get(&arena);
+	char *c = bnx_arena_get(&arena);
+	assert(a != NULL && b != NULL && c != NULL);
+	assert(b - a == arena.object);
+
+	bnx_arena_put(&arena, b);
+	assert(bnx_arena_get(&arena) == b);
+
+	bnx_arena_free(&arena);
+	assert(arena.chunk == NULL);
+}
+
+static void test_stats(void)
+{
+	struct Bnx* empty = bnx_alloc(6);
+	struct BnxStats stats;
+
+	const int solutions = count_solutions(bnx_solve_stats(empty,
+		BNX_GUESS_TOPLEFT, BNX_SOLUTION_MODE_ALL, &stats));
+
+#ifdef BNX_STATS
+	assert(stats.nodes >= solutions);
+	assert(stats.validations == stats.nodes);
+	assert(stats.backtracks == stats.nodes - 1);
+	assert(stats.max_depth > 1 && stats.depth == 0);
+	assert(stats.forced[BNX_RULE_DOUBLE] > 0);
+	assert(stats.boards == 1);
+#else
+	assert(stats.nodes >= solutions && stats.backtracks == 0);
+#endif
+
+	bnx_free(empty);
+}
+
+static void test_random(void)
+{
+	struct Bnx *b = bnx_read_file("data/14x14_veryhard_2.binoxxo");
+	struct BnxStats first;
+	struct BnxStats second;
+	assert(b != NULL);
+
+	struct BnxSolution *expected = bnx_solve(b, BNX_GUESS_TOPLEFT,
+		BNX_SOLUTION_MODE_ONE);
+	struct BnxSolution *s = bnx_solve_stats(b, BNX_GUESS_RANDOM,
+		BNX_SOLUTION_MODE_ONE, &first);
+	assert(s != NULL && s->next == NULL);
+	int row;
+	for (row = 0; row < b->size; row++) {
+		assert(memcmp(s->data->data[row], expected->data->data[row],
+		              b->size * sizeof(int)) == 0);
+	}
+	bnx_solution_free(s);
+
+	// The seed is fixed, a second search takes the same guesses
+	bnx_solution_free(bnx_solve_stats(b, BNX_GUESS_RANDOM,
+		BNX_SOLUTION_MODE_ONE, &second));
+	assert(first.nodes == second.nodes);
+
+	// Restarts never repeat solutions of a complete search
+	struct Bnx *empty = bnx_alloc(6);
+	assert(count_solutions(bnx_solve(empty, BNX_GUESS_RANDOM,
+		BNX_SOLUTION_MODE_ALL)) == count_solutions(bnx_solve(empty,
+		BNX_GUESS_TOPLEFT, BNX_SOLUTION_MODE_ALL)));
+
+	bnx_free(empty);
+	bnx_solution_free(expected);
+	bnx_free(b);
+}
+
+static void test_constrained(void)
+{
+	struct Bnx *empty = bnx_alloc(6);
+	struct BnxBoard board;
+	struct BnxSolverCtx ctx;
+	struct BnxGuess guess;
+
+	assert(count_solutions(bnx_solve(empty, BNX_GUESS_CONSTRAINED,
+		BNX_SOLUTION_MODE_ALL)) == count_solutions(bnx_solve(empty,
+		BNX_GUESS_TOPLEFT, BNX_SOLUTION_MODE_ALL)));
+
+	// Row 1 and column 4 have no room left for another o, only an x can
+	// succeed there
+	bnx_board_init(&board, 6);
+	bnx_board_set(&board, 1, 0, BNX_FIELD_O);
+	bnx_board_set(&board, 1, 2, BNX_FIELD_O);
+	bnx_board_set(&board, 1, 3, BNX_FIELD_O);
+	bnx_board_set(&board, 0, 4, BNX_FIELD_O);
+	bnx_board_set(&board, 2, 4, BNX_FIELD_O);
+	bnx_board_set(&board, 3, 4, BNX_FIELD_O);
+	ctx.board = &board;
+
+	assert(bnx_guesser_constrained(&ctx, &guess));
+	assert(guess.row == 1 && guess.col == 4);
+	assert(guess.field == BNX_FIELD_X);
+
+	// With room for both values the scarcer o is tried first
+	bnx_board_init(&board, 6);
+	bnx_board_set(&board, 1, 0, BNX_FIELD_O);
+	bnx_board_set(&board, 1, 2, BNX_FIELD_O);
+	bnx_board_set(&board, 0, 4, BNX_FIELD_O);
+	bnx_board_set(&board, 2, 4, BNX_FIELD_O);
+	assert(bnx_guesser_constrained(&ctx, &guess));
+	assert(guess.row == 1 && guess.col == 4);
+	assert(guess.field == BNX_FIELD_O);
+
+	bnx_free(empty);
+}
+
+static void test_count(void)
+{
+	struct Bnx *empty = bnx_alloc(6);
+	struct Bnx *witness = bnx_alloc(6);
+	struct Bnx *b = bnx_read_file("data/6x6_1.binoxxo");
+	assert(b != NULL);
+
+	const long all = count_solutions(bnx_solve(empty, BNX_GUESS_TOPLEFT,
+		BNX_SOLUTION_MODE_ALL));
+	assert(bnx_count(empty, BNX_GUESS_TOPLEFT, BNX_SOLUTION_MODE_ALL,
+	                 NULL) == all);
+	assert(bnx_count(empty, BNX_GUESS_TOPLEFT, 2, witness) == 2);
+	assert(bnx_validate(witness) == BNX_CORRECT);
+
+	assert(bnx_count(b, BNX_GUESS_MOSTFILLED, 2, NULL) == 1);
+	struct Bnx *small = bnx_alloc(4);
+	assert(bnx_count(b, BNX_GUESS_TOPLEFT, 2, small) == -EINVAL);
+	bnx_free(small);
+
+	// Three o's in a row can not be solved
+	empty->data[0][0] = BNX_FIELD_O;
+	empty->data[0][1] = BNX_FIELD_O;
+	empty->data[0][2] = BNX_FIELD_O;
+	assert(bnx_count(empty, BNX_GUESS_TOPLEFT, 2, NULL) == 0);
+
+	bnx_free(b);
+	bnx_free(witness);
+	bnx_free(empty);
+}
+
+static int visit_solutions(struct Bnx const *b, void *data)
+{
+	int *left = data;
+
+	assert(bnx_validate(b) == BNX_CORRECT);
+	return --*left > 0;
+}
+
+static void test_visit(void)
+{
+	struct Bnx *empty = bnx_alloc(6);
+	struct BnxSolution *list = NULL;
+	int left = 3;
+
+	assert(bnx_solve_visit(empty, BNX_GUESS_TOPLEFT, &visit_solutions, &left,
+	                       NULL) == 3);
+	assert(left == 0);
+
+	// The solution list is built by a visitor as well
+	const long all = bnx_solve_visit(empty, BNX_GUESS_TOPLEFT,
+	                                 &bnx_visitor_list, &list, NULL);
+	assert(all > 3 && count_solutions(list) == all);
+
+	bnx_free(empty);
+}
+
+static void test_sat(void)
+{
+	struct BnxSat sat;
+	const int clause[] = {1, 2, -1, -2};
+
+	// Exactly one of two variables
+	assert(bnx_sat_init(&sat, 2) == 0);
+	assert(bnx_sat_add_clause(&sat, clause, 2));
+	assert(bnx_sat_add_clause(&sat, clause + 2, 2));
+	assert(bnx_sat_solve(&sat) == BNX_SAT_SAT);
+	assert(bnx_sat_value(&sat, 1) != bnx_sat_value(&sat, 2));
+	assert(bnx_sat_block(&sat, 2));
+	assert(bnx_sat_solve(&sat) == BNX_SAT_SAT);
+	assert(!bnx_sat_block(&sat, 2) || bnx_sat_solve(&sat) == BNX_SAT_UNSAT);
+	bnx_sat_free(&sat);
+
+	// Running out of memory is an error, not an unsatisfiable formula
+	assert(bnx_sat_init(&sat, 2) == 0);
+	sat.error = -ENOMEM;
+	assert(!bnx_sat_add_clause(&sat, clause, 2));
+	assert(!sat.unsat);
+	assert(bnx_sat_solve(&sat) == -ENOMEM);
+	bnx_sat_free(&sat);
+
+	assert(bnx_luby(1) == 1 && bnx_luby(3) == 2 && bnx_luby(7) == 4);
+
+	struct Bnx *b = bnx_read_file("data/14x14_veryhard_1.binoxxo");
+	struct Bnx *empty = bnx_alloc(6);
+	assert(b != NULL);
+
+	struct BnxSolution *expected = bnx_solve(b, BNX_GUESS_TOPLEFT,
+		BNX_SOLUTION_MODE_ALL);
+	struct BnxSolution *s = bnx_solve(b, BNX_GUESS_SAT,
+		BNX_SOLUTION_MODE_ALL);
+	assert(s != NULL && s->next == NULL);
+	int row;
+	for (row = 0; row < b->size; row++) {
+		assert(memcmp(s->data->data[row], expected->data->data[row],
+		              b->size * sizeof(int)) == 0);
+	}
+	bnx_solution_free(s);
+	bnx_solution_free(expected);
+
+	assert(bnx_count(empty, BNX_GUESS_SAT, BNX_SOLUTION_MODE_ALL, NULL)
+		== bnx_count(empty, BNX_GUESS_TOPLEFT, BNX_SOLUTION_MODE_ALL, NULL));
+
+	empty->data[2][0] = BNX_FIELD_X;
+	empty->data[2][1] = BNX_FIELD_X;
+	empty->data[2][2] = BNX_FIELD_X;
+	assert(bnx_count(empty, BNX_GUESS_SAT, 2, NULL) == 0);
+
+	bnx_free(empty);
+	bnx_free(b);
+}
+
+static void test_dimacs(void)
+{
+	struct Bnx *b = bnx_read_file("data/10x10_1.binoxxo");
+	struct Bnx *solution = bnx_alloc(10);
+	FILE *file = tmpfile();
+	struct BnxSat sat;
+	char line[256];
+	int vars = 0;
+	int clauses = 0;
+	int lits[BNX_MAX_SIZE];
+	int n = 0;
+	int lit;
+	assert(b != NULL && file != NULL);
+
+	// Solve the exported formula and read the model back
+	assert(bnx_write_dimacs_stream(file, b) == 0);
+	rewind(file);
+	while (fgets(line, sizeof(line), file) != NULL && line[0] == 'c') {
+	}
+	assert(sscanf(line, "p cnf %d %d", &vars, &clauses) == 2);
+	assert(bnx_sat_init(&sat, vars) == 0);
+	while (fscanf(file, "%d", &lit) == 1) {
+		if (lit == 0) {
+			bnx_sat_add_clause(&sat, lits, n);
+			clauses--;
+			n = 0;
+		} else {
+			lits[n++] = lit;
+		}
+	}
+	assert(clauses == 0);
+	assert(bnx_sat_solve(&sat) == BNX_SAT_SAT);
+	fclose(file);
+
+	char name[] = "/tmp/bnx_model_XXXXXX";
+	const int fd = mkstemp(name);
+	assert(fd >= 0);
+	file = fdopen(fd, "w");
+	fputs("c model\ns SATISFIABLE\nv", file);
+	for (n = 1; n <= vars; n++) {
+		fprintf(file, " %d", bnx_sat_value(&sat, n) ? n : -n);
+	}
+	fputs(" 0\n", file);
+	fclose(file);
+	bnx_sat_free(&sat);
+
+	assert(bnx_read_model(solution, name) == 0);
+	assert(bnx_validate(solution) == BNX_CORRECT);
+
+	file = fopen(name, "w");
+	fputs("s UNSATISFIABLE\n", file);
+	fclose(file);
+	assert(bnx_read_model(solution, name) == -ENOENT);
+
+	file = fopen(name, "w");
+	fputs("v 1 -2 0\n", file);
+	fclose(file);
+	assert(bnx_read_model(solution, name) == -EINVAL);
+
+	remove(name);
+	bnx_free(solution);
+	bnx_free(b);
+}
+
+static void test_generator(void)
+{
+	struct BnxGeneratorWorker w;
+	struct BnxReader reader;
+	struct Bnx *puzzle = bnx_alloc(6);
+	struct Bnx *again = bnx_alloc(6);
+	FILE *file = tmpfile();
+	size_t i;
+	assert(puzzle != NULL && again != NULL && file != NULL);
+	assert(bnx_generator_init(&w, 6) == 0);
+
+	assert(bnx_generator_run(&w, puzzle, 7) == 0);
+	assert(bnx_count(puzzle, BNX_GUESS_TOPLEFT, 2, NULL) == 1);
+
+	// The same seed gives the same puzzle, even after other puzzles
+	assert(bnx_generator_run(&w, again, 8) == 0);
+	assert(bnx_generator_run(&w, again, 7) == 0);
+	for (i = 0; i < 6 * 6; i++) {
+		assert(again->data[0][i] == puzzle->data[0][i]);
+	}
+
+	// Threaded generation writes every puzzle once, in order of the seeds
+	assert(bnx_generate(file, 6, 5, 3, 7, false) == 0);
+	rewind(file);
+	assert(bnx_reader_init(&reader, file) == 0);
+	for (i = 0; (again = bnx_reader_next(&reader, again)) != NULL; i++) {
+		assert(bnx_count(again, BNX_GUESS_TOPLEFT, 2, NULL) == 1);
+		if (i == 0) {
+			assert(memcmp(again->data[0], puzzle->data[0],
+			              36 * sizeof(int)) == 0);
+		}
+	}
+	assert(i == 5);
+	bnx_reader_free(&reader);
+
+	// The output does not depend on the number of threads
+	FILE *single = tmpfile();
+	assert(single != NULL);
+	assert(bnx_generate(single, 6, 5, 1, 7, false) == 0);
+	rewind(file);
+	rewind(single);
+	int c;
+	while ((c = fgetc(file)) != EOF) {
+		assert(fgetc(single) == c);
+	}
+	assert(fgetc(single) == EOF);
+	fclose(single);
+
+	assert(bnx_generate(file, 2, 1, 1, 7, false) == -EINVAL);
+
+	bnx_generator_free(&w);
+	bnx_free(puzzle);
+	fclose(file);
+}
+
+static void test_symmetry(void)
+{
+	struct Bnx *b = bnx_read_file("data/10x10_1.binoxxo");
+	struct Bnx *image = bnx_alloc(10);
+	struct Bnx *back = bnx_alloc(10);
+	struct Bnx *canonical = bnx_alloc(10);
+	struct Bnx *other = bnx_alloc(10);
+	int sym;
+	size_t i;
+	assert(b != NULL && image && back && canonical && other);
+
+	bnx_canonical(canonical, b);
+
+	for (sym = 0; sym < BNX_SYMMETRIES; sym++) {
+		bnx_symmetry_apply(image, b, sym);
+		bnx_symmetry_apply(back, image, bnx_symmetry_inverse(sym));
+		for (i = 0; i < 10 * 10; i++) {
+			assert(back->data[0][i] == b->data[0][i]);
+		}
+
+		// All images share the canonical form
+		const int to_canonical = bnx_canonical(other, image);
+		for (i = 0; i < 10 * 10; i++) {
+			assert(other->data[0][i] == canonical->data[0][i]);
+		}
+		bnx_symmetry_apply(back, image, to_canonical);
+		for (i = 0; i < 10 * 10; i++) {
+			assert(back->data[0][i] == canonical->data[0][i]);
+		}
+	}
+
+	// Solutions stay solutions
+	struct BnxSolution *s = bnx_solve(b, BNX_GUESS_TOPLEFT,
+	                                  BNX_SOLUTION_MODE_ONE);
+	assert(s != NULL);
+	for (sym = 0; sym < BNX_SYMMETRIES; sym++) {
+		bnx_symmetry_apply(image, s->data, sym);
+		assert(bnx_validate(image) == BNX_CORRECT);
+	}
+
+	bnx_solution_free(s);
+	bnx_free(other);
+	bnx_free(canonical);
+	bnx_free(back);
+	bnx_free(image);
+	bnx_free(b);
+}
+
+static void test_cache(void)
+{
+	struct BnxCache cache;
+	struct Bnx *b = bnx_read_file("data/10x10_1.binoxxo");
+	struct Bnx *image = bnx_alloc(10);
+	struct Bnx *empty = bnx_alloc(4);
+	struct Bnx *grid = bnx_alloc(6);
+	struct BnxSolution *s;
+	struct BnxStats stats;
+	size_t i;
+	assert(b != NULL && image != NULL && empty != NULL && grid != NULL);
+	assert(bnx_cache_init(&cache, 1) == 0);
+
+	// An equivalent puzzle is looked up and solved in its orientation
+	bnx_solution_free(bnx_solve_cached(b, BNX_GUESS_TOPLEFT,
+	                                   BNX_SOLUTION_MODE_ALL, &cache, NULL));
+	bnx_symmetry_apply(image, b, BNX_SYM_TRANSPOSE | BNX_SYM_FLIP_COLS
+	                   | BNX_SYM_SWAP);
+	s = bnx_solve_cached(image, BNX_GUESS_TOPLEFT, BNX_SOLUTION_MODE_ONE,
+	                     &cache, &stats);
+	assert(cache.hits == 1 && stats.nodes == 0);
+	assert(s != NULL && s->next == NULL);
+	for (i = 0; i < 10 * 10; i++) {
+		assert(image->data[0][i] == BNX_FIELD_EMPTY
+		       || image->data[0][i] == s->data->data[0][i]);
+	}
+	assert(count_solutions(s) == 1);
+
+	// A search without guesses is not stored as the answer of the puzzle
+	s = bnx_solve_cached(grid, BNX_GUESS_NONE, BNX_SOLUTION_MODE_ALL,
+	                     &cache, NULL);
+	assert(s == NULL);
+	s = bnx_solve_cached(grid, BNX_GUESS_TOPLEFT, BNX_SOLUTION_MODE_ALL,
+	                     &cache, NULL);
+	assert(cache.hits == 1 && count_solutions(s) > 0);
+	bnx_free(grid);
+
+	// One solution does not answer a search for all of them
+	assert(bnx_cache_put(&cache, empty, BNX_SOLUTION_MODE_ONE,
+	                     s = bnx_solve(empty, BNX_GUESS_TOPLEFT,
+	                                   BNX_SOLUTION_MODE_ONE)) == 0);
+	bnx_solution_free(s);
+	assert(!bnx_cache_get(&cache, empty, BNX_SOLUTION_MODE_ALL, &s));
+	assert(bnx_cache_get(&cache, empty, BNX_SOLUTION_MODE_ONE, &s));
+	bnx_solution_free(s);
+
+	// The least recently used entry was dropped
+	assert(cache.count == 1 && !bnx_cache_get(&cache, b, 1, &s));
+
+	char name[] = "/tmp/bnx_cache_XXXXXX";
+	const int fd = mkstemp(name);
+	assert(fd >= 0);
+	fclose(fdopen(fd, "w"));
+	assert(bnx_cache_save(&cache, name) == 0);
+	bnx_cache_free(&cache);
+
+	assert(bnx_cache_init(&cache, 2) == 0);
+	assert(bnx_cache_load(&cache, name) == 0);
+	assert(cache.count == 1);
+	assert(bnx_cache_get(&cache, empty, BNX_SOLUTION_MODE_ONE, &s));
+	assert(count_solutions(s) == 1);
+	remove(name);
+	assert(bnx_cache_load(&cache, name) == -ENOENT);
+
+	bnx_cache_free(&cache);
+	bnx_free(empty);
+	bnx_free(image);
+	bnx_free(b);
+}
+
+static void test_batch(void)
+{
+	struct BnxBatch batch;
+	FILE *file = tmpfile();
+
+	fputs("# two binoxxos\n4\nxxoo\nooxx\nxox_\noxo_\n"
+	      "4 ____ ____ ____ ____\n", file);
+	rewind(file);
+
+	bnx_batch_init(&batch);
+	assert(bnx_batch_add_stream(&batch, file, "tmp") == 0);
+
+	assert(bnx_batch_read(&batch, 1) == 1);
+	bnx_batch_solve(&batch, BNX_GUESS_TOPLEFT, BNX_SOLUTION_MODE_ONE, 2);
+	assert(batch.item[0].solution->data->data[2][3] == BNX_FIELD_O);
+
+	assert(bnx_batch_read(&batch, 2) == 1);
+	assert(batch.item[0].position == 2);
+	bnx_batch_solve(&batch, BNX_GUESS_TOPLEFT, BNX_SOLUTION_MODE_ONE, 2);
+	assert(count_solutions(batch.item[0].solution) == 1);
+	batch.item[0].solution = NULL;
+
+	assert(bnx_batch_read(&batch, 2) == 0);
+	assert(batch.solved == 2);
+
+	// Finished inputs are closed once
+	assert(bnx_batch_read(&batch, 2) == 0 && batch.closed == 1);
+	assert(batch.error == 0);
+
+	bnx_batch_free(&batch);
+	fclose(file);
+
+	// A syntax error fails one binoxxo, reading goes on after it
+	file = tmpfile();
+	fputs("4\nxxoo\nxo\noxo_\n4 ____ ____ ____ ____\n", file);
+	rewind(file);
+	bnx_batch_init(&batch);
+	assert(bnx_batch_add_stream(&batch, file, "tmp") == 0);
+	assert(bnx_batch_read(&batch, 3) == 2);
+	assert(batch.item[0].error == -EINVAL && batch.item[1].error == 0);
+	assert(batch.item[1].position == 2);
+	bnx_batch_solve(&batch, BNX_GUESS_TOPLEFT, BNX_SOLUTION_MODE_ONE, 2);
+	assert(batch.solved == 1 && batch.error == -EINVAL);
+	bnx_batch_free(&batch);
+	fclose(file);
+
+	// Failed binoxxos keep their error and are not counted as solved
+	bnx_batch_init(&batch);
+	assert(bnx_batch_add_path(&batch, "./data/nonexistent") == -ENOENT);
+	assert(bnx_batch_add_path(&batch, "./data/3x3_1.binoxxo") == 0);
+	assert(bnx_batch_read(&batch, 2) == 1);
+	bnx_batch_solve(&batch, BNX_GUESS_TOPLEFT, BNX_SOLUTION_MODE_ONE, 1);
+	assert(batch.item[0].error == -EINVAL);
+	assert(batch.solved == 0 && batch.error == -EINVAL);
+	bnx_batch_free(&batch);
+}
+
+static void test_map(void)
+{
+	struct BnxMap map;
+	const char *file = "./data/6x6_1.binoxxo";
+
+	assert(bnx_map_open(&map, file) == 0);
+	assert(map.count == 1);
+
+	struct Bnx *b = bnx_map_get(&map, 0, NULL);
+	struct Bnx *expected = bnx_read_file(file);
+	assert(b != NULL && expected != NULL);
+	assert(memcmp(b->data[0], expected->data[0],
+	              36 * sizeof(b->data[0][0])) == 0);
+
+	assert(bnx_map_get(&map, 0, b) == b);
+
+	bnx_free(expected);
+	bnx_map_close(&map);
+
+	// A broken binoxxo keeps its place in the index
+	char name[] = "/tmp/binoxxo_map_XXXXXX";
+	const int fd = mkstemp(name);
+	assert(fd >= 0);
+	FILE *stream = fdopen(fd, "w");
+	fputs("4\nxxoo\nxo\noxo_\n4 ____ ____ ____ ____\n", stream);
+	fclose(stream);
+
+	assert(bnx_map_open(&map, name) == 0);
+	assert(map.count == 2);
+	assert((b = bnx_map_get(&map, 0, b)) == NULL);
+	b = bnx_map_get(&map, 1, b);
+	assert(b != NULL && b->size == 4);
+	bnx_map_close(&map);
+	remove(name);
+
+	bnx_free(b);
+}
+
+static void test_binary(void)
+{
+	struct BnxWriter writer;
+	struct BnxMap map;
+	char name[] = "/tmp/binoxxo_test_XXXXXX";
+	struct Bnx *b = bnx_valid_4x4();
+
+	b->data[3][3] = BNX_FIELD_EMPTY;
+
+	const int fd = mkstemp(name);
+	assert(fd >= 0);
+	FILE *file = fdopen(fd, "wb");
+
+	assert(bnx_writer_init(&writer, file) == 0);
+	assert(bnx_writer_add(&writer, b) == 0);
+	assert(bnx_writer_add(&writer, b) == 0);
+	assert(bnx_writer_finish(&writer) == 0);
+	fclose(file);
+
+	assert(bnx_map_open(&map, name) == 0);
+	assert(map.binary && map.size == 4 && map.count == 2);
+	assert(map.length == 24 + 2 * bnx_binary_record_size(4) + 2 * 8);
+
+	struct Bnx *read = bnx_map_get(&map, 1, NULL);
+	assert(read != NULL);
+	assert(memcmp(read->data[0], b->data[0], 16 * sizeof(int)) == 0);
+
+	bnx_map_close(&map);
+
+	// Sizes the binoxxos can not have are rejected at open
+	const size_t sizes[] = {0, 5, 66};
+	size_t i;
+	for (i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+		file = fopen(name, "r+b");
+		assert(file != NULL);
+		const unsigned char size[2] = {sizes[i] & 0xff, sizes[i] >> 8};
+		assert(fseek(file, 6, SEEK_SET) == 0);
+		assert(fwrite(size, 1, 2, file) == 2);
+		fclose(file);
+		assert(bnx_map_open(&map, name) == -EINVAL);
+	}
+
+	bnx_free(read);
+	bnx_free(b);
+	remove(name);
+}
+
 void test(void)
 {
 
@@ -59,5 +894,26 @@ void test(void)
 	
 	//assert(test == NULL);
 
+	test_line();
+	test_board();
+	test_duplicate();
+	test_lines();
+	test_parallel();
+	test_stats();
+	test_random();
+	test_constrained();
+	test_count();
+	test_visit();
+	test_sat();
+	test_dimacs();
+	test_generator();
+	test_symmetry();
+	test_cache();
+	test_arena();
+	test_simd();
+	test_batch();
+	test_map();
+	test_binary();
+
 }
 
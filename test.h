@@ -23,6 +23,17 @@
 #include <assert.h>
 
 #include "binoxxo.h"
+#include "binoxxo_arena.h"
+#include "binoxxo_batch.h"
+#include "binoxxo_board.h"
+#include "binoxxo_cache.h"
+#include "binoxxo_generator.h"
+#include "binoxxo_lines.h"
+#include "binoxxo_parallel.h"
+#include "binoxxo_sat.h"
+#include "binoxxo_simd.h"
+#include "binoxxo_solver.h"
+#include "binoxxo_symmetry.h"
 
 struct Bnx* bnx_valid_4x4(void);
 
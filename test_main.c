@@ -0,0 +1,39 @@
+// 
+// test_main.c
+// Copyright (C) 2014  Florian Tanner <florian.tanner@gmail.com>
+// 
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+// 
+
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "test.h"
+
+#ifdef NDEBUG
+#error "The tests need assert, build them without NDEBUG"
+#endif
+
+///
+/// \brief Run all tests, a failing assert aborts with a nonzero status
+///
+int
+main(void)
+{
+	test();
+	printf("All tests passed\n");
+
+	return EXIT_SUCCESS;
+}